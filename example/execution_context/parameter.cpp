@@ -5,7 +5,6 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <cstdlib>
-#include <exception>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -15,31 +14,23 @@
 
 class X{
 private:
-    std::exception_ptr excptr_;
     boost::context::execution_context caller_;
     boost::context::execution_context callee_;
 
 public:
     X():
-        excptr_(),
         caller_(boost::context::execution_context::current()),
         callee_(
              [=]( void * vp){
-                try {
-                    int i = * static_cast< int * >( vp);
-                    std::string str = boost::lexical_cast<std::string>(i);
-                    caller_( & str);
-                } catch (...) {
-                    excptr_=std::current_exception();
-                }
+                // boost::bad_lexical_cast is rethrown by callee_()
+                int i = * static_cast< int * >( vp);
+                std::string str = boost::lexical_cast<std::string>(i);
+                caller_( & str);
              })
     {}
 
     std::string operator()(int i){
         void * ret = callee_( & i);
-        if(excptr_){
-            std::rethrow_exception(excptr_);
-        }
         return * static_cast< std::string * >( ret);
     }
 };
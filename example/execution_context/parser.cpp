@@ -91,27 +91,22 @@ int main() {
     try {
         std::istringstream is("1+1");
         bool done=false;
-        std::exception_ptr except;
 
         // create handle to main execution context
         auto main_ctx( boost::context::execution_context::current() );
 
         // execute parser in new execution context
         boost::context::execution_context parser_ctx(
-                [&main_ctx,&is,&done,&except](void*){
+                [&main_ctx,&is,&done](void*){
                 // create parser with callback function
                 Parser p( is,
                           [&main_ctx](char ch){
                                 // resume main execution context
                                 main_ctx( & ch);
                         });
-                    try {
-                        // start recursive parsing
-                        p.run();
-                    } catch ( ... ) {
-                        // store other exceptions in exception-pointer
-                        except = std::current_exception();
-                    }
+                    // start recursive parsing; an exception emitted by the
+                    // parser is rethrown by parser_ctx() in main()
+                    p.run();
                     // set termination flag
                     done=true;
                     // resume main execution context
@@ -121,15 +116,9 @@ int main() {
         // user-code pulls parsed data from parser
         // invert control flow
         void * vp = parser_ctx();
-        if ( except) {
-            std::rethrow_exception( except);
-        }
         while( ! done) {
             printf("Parsed: %c\n",* static_cast< char* >( vp) );
             vp = parser_ctx();
-            if ( except) {
-                std::rethrow_exception( except);
-            }
         }
 
         std::cout << "main: done" << std::endl;
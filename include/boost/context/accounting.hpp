@@ -0,0 +1,45 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_ACCOUNTING_H
+#define BOOST_CONTEXT_ACCOUNTING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+struct context_usage {
+    // identifies the context (address of its control structure)
+    void const*                 id;
+    char const*                 name;
+    // time between the resumption and the suspension of the context
+    std::chrono::nanoseconds    cpu_time;
+    std::uint64_t               resumes;
+};
+
+// the `n` live contexts created by the calling thread with the largest
+// cpu_time, in descending order; maintained only if the library was built
+// with BOOST_CONTEXT_USE_ACCOUNTING (accounting=on), empty otherwise
+BOOST_CONTEXT_DECL std::vector< context_usage > top_contexts( std::size_t n);
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_ACCOUNTING_H
@@ -10,4 +10,20 @@
 #include <boost/context/segmented_stack.hpp>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
+#include <boost/context/cancellation.hpp>
 #include <boost/context/execution_context.hpp>
+#include <boost/context/scheduler.hpp>
+#include <boost/context/io_driver.hpp>
+#include <boost/context/timer_wheel.hpp>
+#include <boost/context/mutex.hpp>
+#include <boost/context/condition_variable.hpp>
+#include <boost/context/semaphore.hpp>
+#include <boost/context/channel.hpp>
+#include <boost/context/nursery.hpp>
+#include <boost/context/context_specific_ptr.hpp>
+#include <boost/context/statistics.hpp>
+#include <boost/context/trace.hpp>
+#include <boost/context/accounting.hpp>
+#include <boost/context/histogram.hpp>
+#include <boost/context/registry.hpp>
+#include <boost/context/profiler.hpp>
@@ -0,0 +1,96 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_CANCELLATION_H
+#define BOOST_CONTEXT_CANCELLATION_H
+
+#include <atomic>
+#include <cstddef>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+#include <boost/intrusive_ptr.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+// thrown at a suspension point of a cancelled or destroyed context, unwinds
+// its stack; not derived from std::exception, handlers catching it have to
+// rethrow it
+struct forced_unwind {
+};
+
+namespace detail {
+
+struct cancellation_state {
+    std::atomic< std::size_t >  use_count;
+    std::atomic< bool >         requested;
+
+    cancellation_state() noexcept :
+        use_count( 0),
+        requested( false) {
+    }
+
+    friend void intrusive_ptr_add_ref( cancellation_state * s) noexcept {
+        s->use_count.fetch_add( 1, std::memory_order_relaxed);
+    }
+
+    friend void intrusive_ptr_release( cancellation_state * s) noexcept {
+        BOOST_ASSERT( nullptr != s);
+        if ( 1 == s->use_count.fetch_sub( 1, std::memory_order_acq_rel) ) {
+            delete s;
+        }
+    }
+};
+
+}
+
+// shared cancellation request; copies refer to the same request, cancel()
+// might be called by any thread
+class cancellation_token {
+private:
+    friend class execution_context;
+
+    boost::intrusive_ptr< detail::cancellation_state >  state_;
+
+    explicit cancellation_token( detail::cancellation_state * state) noexcept :
+        state_( state) {
+    }
+
+public:
+    cancellation_token() :
+        state_( new detail::cancellation_state() ) {
+    }
+
+    void cancel() noexcept {
+        state_->requested.store( true, std::memory_order_relaxed);
+    }
+
+    bool cancelled() const noexcept {
+        return state_->requested.load( std::memory_order_relaxed);
+    }
+
+    bool operator==( cancellation_token const& other) const noexcept {
+        return state_ == other.state_;
+    }
+
+    bool operator!=( cancellation_token const& other) const noexcept {
+        return state_ != other.state_;
+    }
+};
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_CANCELLATION_H
@@ -0,0 +1,558 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_CHANNEL_H
+#define BOOST_CONTEXT_CHANNEL_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <atomic>
+# include <chrono>
+# include <cstddef>
+# include <memory>
+# include <new>
+# include <type_traits>
+# include <utility>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# include <boost/context/detail/spinlock.hpp>
+# include <boost/context/detail/wait_queue.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+enum class channel_op_status {
+    success = 0,
+    empty,
+    full,
+    closed,
+    timeout
+};
+
+struct select_result {
+    // index of the completed case, number of cases on timeout
+    std::size_t         index;
+    channel_op_status   status;
+};
+
+namespace detail {
+
+template< bool Concurrent >
+class channel_lock;
+
+template<>
+class channel_lock< true > {
+private:
+    spinlock    splk_;
+
+public:
+    void lock() noexcept {
+        splk_.lock();
+    }
+
+    void unlock() noexcept {
+        splk_.unlock();
+    }
+
+    spinlock * native() noexcept {
+        return & splk_;
+    }
+};
+
+// all parties run on one thread, nothing to protect
+template<>
+class channel_lock< false > {
+public:
+    void lock() noexcept {
+    }
+
+    void unlock() noexcept {
+    }
+
+    spinlock * native() noexcept {
+        return nullptr;
+    }
+};
+
+// a context blocked in push() or pop(); the partner moves the value
+// from/to `item` directly
+template< typename T >
+struct channel_waiter : public waiter {
+    T                   *   item;
+    channel_op_status       status;
+
+    explicit channel_waiter( T * item_) noexcept :
+        waiter(),
+        item( item_),
+        status( channel_op_status::success) {
+    }
+};
+
+// type-erased operation of a select()
+class select_case {
+public:
+    virtual ~select_case() {}
+
+    // identity of the channel, defines the lock order
+    virtual void const* channel() const noexcept = 0;
+
+    virtual void lock() noexcept = 0;
+
+    virtual void unlock() noexcept = 0;
+
+    // lock held; true if the operation has been completed
+    virtual bool try_locked( channel_op_status &, waiter *&) = 0;
+
+    virtual void enqueue_locked( std::atomic< waiter * > *) noexcept = 0;
+
+    virtual void dequeue_locked() noexcept = 0;
+
+    virtual waiter const* node() const noexcept = 0;
+
+    virtual channel_op_status status() const noexcept = 0;
+};
+
+BOOST_CONTEXT_DECL
+select_result select_( select_case ** cases, select_case ** order, std::size_t n,
+                       std::chrono::steady_clock::time_point deadline);
+
+template< typename Channel >
+class select_push_case;
+
+template< typename Channel >
+class select_pop_case;
+
+}
+
+// bounded FIFO between contexts; push() suspends the running context
+// while the channel is full, pop() while it is empty
+// a value is passed directly to a waiting consumer, bypassing the buffer
+// the woken party is only made ready, the caller keeps running and
+// moves a batch of values per switch
+// `Concurrent = false` restricts the channel to the contexts of one
+// thread and removes all locking
+template< typename T, bool Concurrent = true >
+class channel {
+public:
+    typedef T   value_type;
+
+private:
+    template< typename > friend class detail::select_push_case;
+    template< typename > friend class detail::select_pop_case;
+
+    typedef typename std::aligned_storage<
+        sizeof( value_type), alignof( value_type)
+    >::type                                             storage_type;
+
+    detail::channel_lock< Concurrent >      lk_;
+    std::size_t                             capacity_;
+    std::unique_ptr< storage_type[] >       slots_;
+    std::size_t                             head_;
+    std::size_t                             size_;
+    bool                                    closed_;
+    detail::wait_queue                      producers_;
+    detail::wait_queue                      consumers_;
+
+    value_type * slot_( std::size_t idx) noexcept {
+        return reinterpret_cast< value_type * >( & slots_[idx]);
+    }
+
+    void emplace_back_( value_type && v) {
+        BOOST_ASSERT( size_ < capacity_);
+        std::size_t tail = head_ + size_;
+        if ( tail >= capacity_) {
+            tail -= capacity_;
+        }
+        ::new ( slot_( tail) ) value_type( std::move( v) );
+        ++size_;
+    }
+
+    // lock held; false if the caller has to wait
+    // `wake` receives the waiter to be woken after releasing the lock
+    bool push_locked_( value_type & v, channel_op_status & status, detail::waiter *& wake) {
+        if ( closed_) {
+            status = channel_op_status::closed;
+            return true;
+        }
+        if ( detail::waiter * w = consumers_.pop_front() ) {
+            // direct hand-off
+            detail::channel_waiter< value_type > * cw = static_cast< detail::channel_waiter< value_type > * >( w);
+            * cw->item = std::move( v);
+            cw->status = channel_op_status::success;
+            wake = w;
+            status = channel_op_status::success;
+            return true;
+        }
+        if ( size_ < capacity_) {
+            emplace_back_( std::move( v) );
+            status = channel_op_status::success;
+            return true;
+        }
+        return false;
+    }
+
+    bool pop_locked_( value_type & v, channel_op_status & status, detail::waiter *& wake) {
+        if ( 0 < size_) {
+            value_type * p = slot_( head_);
+            v = std::move( * p);
+            p->~value_type();
+            if ( ++head_ == capacity_) {
+                head_ = 0;
+            }
+            --size_;
+            // the first blocked producer takes the free slot
+            if ( detail::waiter * w = producers_.pop_front() ) {
+                detail::channel_waiter< value_type > * cw = static_cast< detail::channel_waiter< value_type > * >( w);
+                emplace_back_( std::move( * cw->item) );
+                cw->status = channel_op_status::success;
+                wake = w;
+            }
+            status = channel_op_status::success;
+            return true;
+        }
+        if ( closed_) {
+            status = channel_op_status::closed;
+            return true;
+        }
+        return false;
+    }
+
+    channel_op_status push_( value_type & v, std::chrono::steady_clock::time_point deadline) {
+        detail::wait_queue::checkpoint();
+        lk_.lock();
+        channel_op_status status;
+        detail::waiter * wake = nullptr;
+        if ( push_locked_( v, status, wake) ) {
+            lk_.unlock();
+            if ( nullptr != wake) {
+                detail::wait_queue::wake( wake);
+            }
+            return status;
+        }
+        detail::channel_waiter< value_type > w( & v);
+        producers_.push_back( & w);
+        if ( ! detail::wait_queue::suspend( lk_.native(), w, deadline) ) {
+            return channel_op_status::timeout;
+        }
+        return w.status;
+    }
+
+    channel_op_status pop_( value_type & v, std::chrono::steady_clock::time_point deadline) {
+        detail::wait_queue::checkpoint();
+        lk_.lock();
+        channel_op_status status;
+        detail::waiter * wake = nullptr;
+        if ( pop_locked_( v, status, wake) ) {
+            lk_.unlock();
+            if ( nullptr != wake) {
+                detail::wait_queue::wake( wake);
+            }
+            return status;
+        }
+        detail::channel_waiter< value_type > w( & v);
+        consumers_.push_back( & w);
+        if ( ! detail::wait_queue::suspend( lk_.native(), w, deadline) ) {
+            return channel_op_status::timeout;
+        }
+        return w.status;
+    }
+
+    template< typename Fn >
+    channel_op_status try_( Fn && fn, channel_op_status fail) {
+        lk_.lock();
+        channel_op_status status = fail;
+        detail::waiter * wake = nullptr;
+        fn( status, wake);
+        lk_.unlock();
+        if ( nullptr != wake) {
+            detail::wait_queue::wake( wake);
+        }
+        return status;
+    }
+
+public:
+    explicit channel( std::size_t capacity) :
+        lk_(),
+        capacity_( capacity),
+        slots_( new storage_type[capacity]),
+        head_( 0),
+        size_( 0),
+        closed_( false),
+        producers_(),
+        consumers_() {
+        BOOST_ASSERT( 0 < capacity_);
+    }
+
+    ~channel() {
+        BOOST_ASSERT( producers_.empty() );
+        BOOST_ASSERT( consumers_.empty() );
+        for ( ; 0 < size_; --size_) {
+            slot_( head_)->~value_type();
+            if ( ++head_ == capacity_) {
+                head_ = 0;
+            }
+        }
+    }
+
+    channel( channel const&) = delete;
+    channel & operator=( channel const&) = delete;
+
+    std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    bool is_closed() noexcept {
+        lk_.lock();
+        const bool closed = closed_;
+        lk_.unlock();
+        return closed;
+    }
+
+    // wakes all waiting contexts; buffered values can still be popped
+    void close() noexcept {
+        detail::waiter * head;
+        lk_.lock();
+        closed_ = true;
+        head = producers_.pop_all();
+        detail::waiter ** tail = & head;
+        while ( nullptr != * tail) {
+            tail = & ( * tail)->next;
+        }
+        * tail = consumers_.pop_all();
+        for ( detail::waiter * w = head; nullptr != w; w = w->next) {
+            // producers and consumers share the layout of channel_waiter
+            static_cast< detail::channel_waiter< value_type > * >( w)->status = channel_op_status::closed;
+        }
+        lk_.unlock();
+        detail::wait_queue::wake_all( head);
+    }
+
+    channel_op_status push( value_type const& v) {
+        value_type tmp( v);
+        return push_( tmp, std::chrono::steady_clock::time_point::max() );
+    }
+
+    channel_op_status push( value_type && v) {
+        return push_( v, std::chrono::steady_clock::time_point::max() );
+    }
+
+    channel_op_status try_push( value_type const& v) {
+        value_type tmp( v);
+        return try_push( std::move( tmp) );
+    }
+
+    channel_op_status try_push( value_type && v) {
+        return try_( [this,&v]( channel_op_status & status, detail::waiter *& wake) {
+                        push_locked_( v, status, wake);
+                     }, channel_op_status::full);
+    }
+
+    template< typename Clock, typename Duration >
+    channel_op_status push_wait_until( value_type && v, std::chrono::time_point< Clock, Duration > const& tp) {
+        return push_( v, detail::to_steady( tp) );
+    }
+
+    template< typename Rep, typename Period >
+    channel_op_status push_wait_for( value_type && v, std::chrono::duration< Rep, Period > const& d) {
+        return push_( v, std::chrono::steady_clock::now() + d);
+    }
+
+    channel_op_status pop( value_type & v) {
+        return pop_( v, std::chrono::steady_clock::time_point::max() );
+    }
+
+    channel_op_status try_pop( value_type & v) {
+        return try_( [this,&v]( channel_op_status & status, detail::waiter *& wake) {
+                        pop_locked_( v, status, wake);
+                     }, channel_op_status::empty);
+    }
+
+    template< typename Clock, typename Duration >
+    channel_op_status pop_wait_until( value_type & v, std::chrono::time_point< Clock, Duration > const& tp) {
+        return pop_( v, detail::to_steady( tp) );
+    }
+
+    template< typename Rep, typename Period >
+    channel_op_status pop_wait_for( value_type & v, std::chrono::duration< Rep, Period > const& d) {
+        return pop_( v, std::chrono::steady_clock::now() + d);
+    }
+};
+
+// channel restricted to the contexts of one thread
+template< typename T >
+using local_channel = channel< T, false >;
+
+namespace detail {
+
+template< typename Channel >
+class select_push_case : public select_case {
+private:
+    typedef typename Channel::value_type    value_type;
+
+    Channel                         &   ch_;
+    value_type                      &   v_;
+    channel_waiter< value_type >        node_;
+
+public:
+    select_push_case( Channel & ch, value_type & v) noexcept :
+        ch_( ch),
+        v_( v),
+        node_( & v) {
+    }
+
+    // returned by select_push(), not enqueued yet
+    select_push_case( select_push_case const& other) noexcept :
+        ch_( other.ch_),
+        v_( other.v_),
+        node_( & other.v_) {
+    }
+
+    void const* channel() const noexcept override {
+        return & ch_;
+    }
+
+    void lock() noexcept override {
+        ch_.lk_.lock();
+    }
+
+    void unlock() noexcept override {
+        ch_.lk_.unlock();
+    }
+
+    bool try_locked( channel_op_status & status, waiter *& wake) override {
+        return ch_.push_locked_( v_, status, wake);
+    }
+
+    void enqueue_locked( std::atomic< waiter * > * selected) noexcept override {
+        node_.selected = selected;
+        ch_.producers_.push_back( & node_);
+    }
+
+    void dequeue_locked() noexcept override {
+        if ( nullptr != node_.queue) {
+            node_.queue->remove( & node_);
+        }
+    }
+
+    waiter const* node() const noexcept override {
+        return & node_;
+    }
+
+    channel_op_status status() const noexcept override {
+        return node_.status;
+    }
+};
+
+template< typename Channel >
+class select_pop_case : public select_case {
+private:
+    typedef typename Channel::value_type    value_type;
+
+    Channel                         &   ch_;
+    value_type                      &   v_;
+    channel_waiter< value_type >        node_;
+
+public:
+    select_pop_case( Channel & ch, value_type & v) noexcept :
+        ch_( ch),
+        v_( v),
+        node_( & v) {
+    }
+
+    // returned by select_pop(), not enqueued yet
+    select_pop_case( select_pop_case const& other) noexcept :
+        ch_( other.ch_),
+        v_( other.v_),
+        node_( & other.v_) {
+    }
+
+    void const* channel() const noexcept override {
+        return & ch_;
+    }
+
+    void lock() noexcept override {
+        ch_.lk_.lock();
+    }
+
+    void unlock() noexcept override {
+        ch_.lk_.unlock();
+    }
+
+    bool try_locked( channel_op_status & status, waiter *& wake) override {
+        return ch_.pop_locked_( v_, status, wake);
+    }
+
+    void enqueue_locked( std::atomic< waiter * > * selected) noexcept override {
+        node_.selected = selected;
+        ch_.consumers_.push_back( & node_);
+    }
+
+    void dequeue_locked() noexcept override {
+        if ( nullptr != node_.queue) {
+            node_.queue->remove( & node_);
+        }
+    }
+
+    waiter const* node() const noexcept override {
+        return & node_;
+    }
+
+    channel_op_status status() const noexcept override {
+        return node_.status;
+    }
+};
+
+}
+
+// cases of select(); `v` must outlive the select
+template< typename T, bool Concurrent >
+detail::select_push_case< channel< T, Concurrent > >
+select_push( channel< T, Concurrent > & ch, T & v) noexcept {
+    return detail::select_push_case< channel< T, Concurrent > >( ch, v);
+}
+
+template< typename T, bool Concurrent >
+detail::select_pop_case< channel< T, Concurrent > >
+select_pop( channel< T, Concurrent > & ch, T & v) noexcept {
+    return detail::select_pop_case< channel< T, Concurrent > >( ch, v);
+}
+
+// completes the first of the operations that can be completed,
+// suspends the running context until one can be completed otherwise
+// ready operations are preferred in the order of the arguments
+template< typename Clock, typename Duration, typename ... Cases >
+select_result select_until( std::chrono::time_point< Clock, Duration > const& tp, Cases && ... cases) {
+    detail::select_case * c[] = { & cases ... };
+    detail::select_case * order[sizeof ... ( Cases)];
+    return detail::select_( c, order, sizeof ... ( Cases), detail::to_steady( tp) );
+}
+
+template< typename Rep, typename Period, typename ... Cases >
+select_result select_for( std::chrono::duration< Rep, Period > const& d, Cases && ... cases) {
+    return select_until( std::chrono::steady_clock::now() + d, std::forward< Cases >( cases) ... );
+}
+
+template< typename ... Cases >
+select_result select( Cases && ... cases) {
+    return select_until( std::chrono::steady_clock::time_point::max(), std::forward< Cases >( cases) ... );
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_CHANNEL_H
@@ -0,0 +1,103 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_CONDITION_VARIABLE_H
+#define BOOST_CONTEXT_CONDITION_VARIABLE_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <chrono>
+# include <condition_variable>
+# include <mutex>
+
+# include <boost/config.hpp>
+
+# include <boost/context/detail/spinlock.hpp>
+# include <boost/context/detail/wait_queue.hpp>
+# include <boost/context/mutex.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+using std::cv_status;
+
+// condition variable for boost::context::mutex; waiting contexts
+// are suspended and notified in FIFO order
+class BOOST_CONTEXT_DECL condition_variable {
+private:
+    detail::spinlock        splk_;
+    detail::wait_queue      waiters_;
+
+    bool wait_( std::unique_lock< mutex > & lk, std::chrono::steady_clock::time_point deadline) noexcept;
+
+public:
+    condition_variable() noexcept;
+
+    ~condition_variable();
+
+    condition_variable( condition_variable const&) = delete;
+    condition_variable & operator=( condition_variable const&) = delete;
+
+    void notify_one() noexcept;
+
+    void notify_all() noexcept;
+
+    void wait( std::unique_lock< mutex > & lk) noexcept {
+        wait_( lk, std::chrono::steady_clock::time_point::max() );
+    }
+
+    template< typename Pred >
+    void wait( std::unique_lock< mutex > & lk, Pred pred) {
+        while ( ! pred() ) {
+            wait( lk);
+        }
+    }
+
+    template< typename Clock, typename Duration >
+    cv_status wait_until( std::unique_lock< mutex > & lk,
+                          std::chrono::time_point< Clock, Duration > const& tp) {
+        return wait_( lk, detail::to_steady( tp) ) ? cv_status::no_timeout : cv_status::timeout;
+    }
+
+    template< typename Clock, typename Duration, typename Pred >
+    bool wait_until( std::unique_lock< mutex > & lk,
+                     std::chrono::time_point< Clock, Duration > const& tp, Pred pred) {
+        const std::chrono::steady_clock::time_point deadline = detail::to_steady( tp);
+        while ( ! pred() ) {
+            if ( cv_status::timeout == wait_until( lk, deadline) ) {
+                return pred();
+            }
+        }
+        return true;
+    }
+
+    template< typename Rep, typename Period >
+    cv_status wait_for( std::unique_lock< mutex > & lk,
+                        std::chrono::duration< Rep, Period > const& d) {
+        return wait_until( lk, std::chrono::steady_clock::now() + d);
+    }
+
+    template< typename Rep, typename Period, typename Pred >
+    bool wait_for( std::unique_lock< mutex > & lk,
+                   std::chrono::duration< Rep, Period > const& d, Pred pred) {
+        return wait_until( lk, std::chrono::steady_clock::now() + d, pred);
+    }
+};
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_CONDITION_VARIABLE_H
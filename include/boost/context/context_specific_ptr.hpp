@@ -0,0 +1,108 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_CONTEXT_SPECIFIC_PTR_H
+#define BOOST_CONTEXT_CONTEXT_SPECIFIC_PTR_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <cstddef>
+# include <memory>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# include <boost/context/detail/fls.hpp>
+# include <boost/context/execution_context.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+// pointer with a distinct value per execution context (counterpart of
+// boost::thread_specific_ptr<>); the value is stored in a slot of the
+// activation record, the lookup costs an index into the slot table of
+// the running context
+// the values are cleaned up by a default constructed `Cleanup` when the
+// activation record is deallocated
+template< typename T, typename Cleanup = std::default_delete< T > >
+class context_specific_ptr {
+public:
+    typedef T   element_type;
+
+private:
+    std::size_t     idx_;
+
+    static void cleanup_( void * vp) {
+        Cleanup()( static_cast< T * >( vp) );
+    }
+
+    static detail::activation_record * record_() noexcept {
+        detail::activation_record * ar = detail::activation_record::current_rec.get();
+        if ( BOOST_UNLIKELY( nullptr == ar) ) {
+            // no context was created on this thread yet
+            execution_context::current();
+            ar = detail::activation_record::current_rec.get();
+        }
+        return ar;
+    }
+
+public:
+    context_specific_ptr() :
+        idx_( detail::fls_register( & context_specific_ptr::cleanup_) ) {
+    }
+
+    context_specific_ptr( context_specific_ptr const&) = delete;
+    context_specific_ptr & operator=( context_specific_ptr const&) = delete;
+
+    T * get() const noexcept {
+        return static_cast< T * >( record_()->fls.get( idx_) );
+    }
+
+    T * operator->() const noexcept {
+        return get();
+    }
+
+    T & operator*() const noexcept {
+        BOOST_ASSERT( nullptr != get() );
+        return * get();
+    }
+
+    T * release() noexcept {
+        detail::activation_record * ar = record_();
+        T * p = static_cast< T * >( ar->fls.get( idx_) );
+        if ( nullptr != p) {
+            ar->fls.set( idx_, nullptr);
+        }
+        return p;
+    }
+
+    // the previous value is cleaned up
+    void reset( T * p = nullptr) {
+        detail::activation_record * ar = record_();
+        T * old = static_cast< T * >( ar->fls.get( idx_) );
+        if ( old != p) {
+            ar->fls.set( idx_, p);
+            if ( nullptr != old) {
+                cleanup_( old);
+            }
+        }
+    }
+};
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_CONTEXT_SPECIFIC_PTR_H
@@ -0,0 +1,92 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_ACCOUNTING_H
+#define BOOST_CONTEXT_DETAIL_ACCOUNTING_H
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING)
+# include <atomic>
+# include <chrono>
+# include <cstdint>
+
+# include <boost/context/detail/clock.hpp>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING)
+// base of activation_record; accumulates the run time of the context
+struct BOOST_CONTEXT_DECL accounting_hook {
+    // written by the thread running the context (relaxed load + store)
+    std::atomic< std::uint64_t >    run_ticks;
+    std::atomic< std::uint64_t >    resumes;
+
+    // time stamp of the last switch of the calling thread, 0 before the
+    // first switch
+    thread_local static std::uint64_t   last_switch_;
+
+    accounting_hook() noexcept :
+        run_ticks( 0),
+        resumes( 0) {
+    }
+
+    accounting_hook( accounting_hook const&) = delete;
+    accounting_hook & operator=( accounting_hook const&) = delete;
+};
+
+// charges the time since the last switch of this thread to `from`
+inline
+void account( accounting_hook * from, accounting_hook * to) noexcept {
+    const std::uint64_t now = ticks();
+    const std::uint64_t last = accounting_hook::last_switch_;
+    if ( 0 != last) {
+        from->run_ticks.store( from->run_ticks.load( std::memory_order_relaxed) + ( now - last),
+                               std::memory_order_relaxed);
+    }
+    accounting_hook::last_switch_ = now;
+    to->resumes.store( to->resumes.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// run time of `h`, including the running slice if `h` is the context of
+// the calling thread
+inline
+std::uint64_t run_ticks( accounting_hook const* h, bool running) noexcept {
+    std::uint64_t t = h->run_ticks.load( std::memory_order_relaxed);
+    const std::uint64_t last = accounting_hook::last_switch_;
+    if ( running && 0 != last) {
+        t += ticks() - last;
+    }
+    return t;
+}
+
+BOOST_CONTEXT_DECL std::chrono::nanoseconds ticks_to_ns( std::uint64_t t) noexcept;
+
+# define BOOST_CONTEXT_ACCOUNT( from, to) \
+    ::boost::context::detail::account( from, to)
+#else
+// empty base, the disabled build does not touch the switch path
+struct accounting_hook {
+};
+
+# define BOOST_CONTEXT_ACCOUNT( from, to) ((void)0)
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_ACCOUNTING_H
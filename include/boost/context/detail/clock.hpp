@@ -0,0 +1,61 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_CLOCK_H
+#define BOOST_CONTEXT_DETAIL_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+# include <intrin.h>
+# define BOOST_CONTEXT_TICKS_TSC
+#elif defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+# include <x86intrin.h>
+# define BOOST_CONTEXT_TICKS_TSC
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+// cheap time stamp taken on the switch path by the diagnostics: the
+// unfenced time stamp counter on x86 (requires an invariant TSC to be
+// converted to time), steady_clock nanoseconds elsewhere
+#if defined(BOOST_CONTEXT_TICKS_TSC)
+constexpr bool ticks_are_tsc = true;
+#else
+constexpr bool ticks_are_tsc = false;
+#endif
+
+inline
+std::uint64_t ticks() noexcept {
+#if defined(BOOST_CONTEXT_TICKS_TSC)
+    return __rdtsc();
+#else
+    return static_cast< std::uint64_t >(
+        std::chrono::duration_cast< std::chrono::nanoseconds >(
+            std::chrono::steady_clock::now().time_since_epoch() ).count() );
+#endif
+}
+
+// nanoseconds per tick
+BOOST_CONTEXT_DECL double ns_per_tick() noexcept;
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_CLOCK_H
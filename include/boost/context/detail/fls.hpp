@@ -0,0 +1,112 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_FLS_H
+#define BOOST_CONTEXT_DETAIL_FLS_H
+
+#include <cstddef>
+#include <cstring>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_FLS_SLOTS)
+# define BOOST_CONTEXT_FLS_SLOTS 64
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+typedef void (* fls_cleanup_t)( void *);
+
+// returns a new slot index, `cleanup` is applied to the non-null values of
+// the slot when an activation record is destroyed
+// slots are never recycled, values of a slot can outlive its owner
+BOOST_CONTEXT_DECL std::size_t fls_register( fls_cleanup_t cleanup);
+
+BOOST_CONTEXT_DECL fls_cleanup_t fls_cleanup( std::size_t idx) noexcept;
+
+// number of registered slots
+BOOST_CONTEXT_DECL std::size_t fls_slots() noexcept;
+
+// context-local values, indexed by slot
+class fls_table {
+private:
+    void        **  values_;
+    std::size_t     size_;
+
+public:
+    fls_table() noexcept :
+        values_( nullptr),
+        size_( 0) {
+    }
+
+    ~fls_table() {
+        clear();
+    }
+
+    fls_table( fls_table const&) = delete;
+    fls_table & operator=( fls_table const&) = delete;
+
+    void * get( std::size_t idx) const noexcept {
+        return idx < size_ ? values_[idx] : nullptr;
+    }
+
+    void set( std::size_t idx, void * vp) {
+        if ( idx >= size_) {
+            if ( nullptr == vp) {
+                return;
+            }
+            // grow to all slots registered so far
+            const std::size_t size = fls_slots();
+            BOOST_ASSERT( idx < size);
+            void ** values = new void *[size];
+            if ( 0 < size_) {
+                std::memcpy( values, values_, size_ * sizeof( void *) );
+            }
+            std::memset( values + size_, 0, ( size - size_) * sizeof( void *) );
+            delete [] values_;
+            values_ = values;
+            size_ = size;
+        }
+        values_[idx] = vp;
+    }
+
+    // run the cleanup functions; a cleanup function might store
+    // new values, the table is scanned until it remains empty
+    // (at most four passes)
+    void clear() noexcept {
+        bool dirty = nullptr != values_;
+        for ( unsigned int pass = 0; dirty && pass < 4; ++pass) {
+            dirty = false;
+            for ( std::size_t idx = 0; idx < size_; ++idx) {
+                void * vp = values_[idx];
+                if ( nullptr != vp) {
+                    values_[idx] = nullptr;
+                    fls_cleanup( idx)( vp);
+                    dirty = true;
+                }
+            }
+        }
+        delete [] values_;
+        values_ = nullptr;
+        size_ = 0;
+    }
+};
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_FLS_H
@@ -0,0 +1,85 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_FUTEX_H
+#define BOOST_CONTEXT_DETAIL_FUTEX_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(__linux__)
+extern "C" {
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+}
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+typedef std::atomic< std::int32_t >     futex_type;
+
+#if defined(__linux__)
+// block while `* addr == value`, at most until `deadline`;
+// spurious wake-ups are possible
+inline
+void futex_wait( futex_type * addr, std::int32_t value,
+                 std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max() ) noexcept {
+    if ( std::chrono::steady_clock::time_point::max() == deadline) {
+        ::syscall( SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+        return;
+    }
+    const std::chrono::nanoseconds rel = std::chrono::duration_cast< std::chrono::nanoseconds >(
+            deadline - std::chrono::steady_clock::now() );
+    if ( std::chrono::nanoseconds::zero() >= rel) {
+        return;
+    }
+    // FUTEX_WAIT measures the relative timeout against CLOCK_MONOTONIC
+    timespec ts;
+    ts.tv_sec = static_cast< time_t >( rel.count() / 1000000000);
+    ts.tv_nsec = static_cast< long >( rel.count() % 1000000000);
+    ::syscall( SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, & ts, nullptr, 0);
+}
+
+inline
+void futex_wake( futex_type * addr, std::int32_t count) noexcept {
+    ::syscall( SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+#else
+// no futex available: back off by yielding the time slice
+inline
+void futex_wait( futex_type * addr, std::int32_t value,
+                 std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max() ) noexcept {
+    if ( value == addr->load( std::memory_order_acquire) &&
+         std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+inline
+void futex_wake( futex_type *, std::int32_t) noexcept {
+}
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_FUTEX_H
@@ -0,0 +1,162 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_HISTOGRAM_H
+#define BOOST_CONTEXT_DETAIL_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+# include <intrin.h>
+#endif
+
+#if defined(BOOST_CONTEXT_USE_HISTOGRAMS)
+# include <atomic>
+
+# include <boost/context/detail/clock.hpp>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+// log-linear buckets: values below 2^histogram_sub_bits are counted
+// exactly, above each power of two is split into 2^histogram_sub_bits
+// linear sub-buckets (relative error below 1/2^histogram_sub_bits)
+constexpr unsigned histogram_sub_bits = 5;
+constexpr std::size_t histogram_sub_buckets = std::size_t( 1) << histogram_sub_bits;
+constexpr std::size_t histogram_buckets = ( 65 - histogram_sub_bits) * histogram_sub_buckets;
+
+inline
+unsigned histogram_msb( std::uint64_t v) noexcept {
+#if defined(__GNUC__)
+    return 63 - static_cast< unsigned >( __builtin_clzll( v) );
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanReverse64( & i, v);
+    return static_cast< unsigned >( i);
+#else
+    unsigned i = 0;
+    while ( 0 != ( v >>= 1) ) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+inline
+std::size_t histogram_bucket( std::uint64_t v) noexcept {
+    if ( v < histogram_sub_buckets) {
+        return static_cast< std::size_t >( v);
+    }
+    const unsigned msb = histogram_msb( v);
+    const unsigned shift = msb - histogram_sub_bits;
+    return ( shift + 1) * histogram_sub_buckets +
+           static_cast< std::size_t >( ( v >> shift) - histogram_sub_buckets);
+}
+
+// smallest value counted by bucket `i`
+inline
+std::uint64_t histogram_lower( std::size_t i) noexcept {
+    if ( i < histogram_sub_buckets) {
+        return i;
+    }
+    const std::size_t shift = i / histogram_sub_buckets - 1;
+    return static_cast< std::uint64_t >( histogram_sub_buckets + i % histogram_sub_buckets) << shift;
+}
+
+// largest value counted by bucket `i`
+inline
+std::uint64_t histogram_upper( std::size_t i) noexcept {
+    return i + 1 < histogram_buckets ? histogram_lower( i + 1) - 1 : ~std::uint64_t( 0);
+}
+
+#if defined(BOOST_CONTEXT_USE_HISTOGRAMS)
+// base of activation_record
+struct histogram_hook {
+    // time stamp of the last suspension, 0 while never suspended
+    std::uint64_t   suspended_at;
+
+    histogram_hook() noexcept :
+        suspended_at( 0) {
+    }
+};
+
+// histograms of one thread in ticks; written only by the owning thread
+// (relaxed load + store), read by aggregate_histograms(); released blocks
+// are recycled by new threads
+struct BOOST_CONTEXT_DECL histogram_block {
+    // time stamp of the last switch of the thread, 0 before the first
+    std::uint64_t                   last_switch;
+    std::atomic< std::uint64_t >    run_slice[histogram_buckets];
+    std::atomic< std::uint64_t >    suspended[histogram_buckets];
+    histogram_block             *   nxt;
+    bool                            in_use;
+
+    // block of the calling thread, nullptr before the first access
+    thread_local static histogram_block *   current_;
+
+    static histogram_block * attach() noexcept;
+
+    static histogram_block & current() noexcept {
+        histogram_block * b = current_;
+        return nullptr != b ? * b : * attach();
+    }
+};
+
+inline
+void add( std::atomic< std::uint64_t > & c) noexcept {
+    c.store( c.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// `to` might have been suspended by another thread, the counters of the
+// processors are not exactly synchronized
+inline
+std::uint64_t elapsed( std::uint64_t now, std::uint64_t then) noexcept {
+    return now > then ? now - then : 0;
+}
+
+// `from` ran since the last switch of this thread, `to` was suspended since
+// its last switch
+inline
+void record_switch( histogram_hook * from, histogram_hook * to) noexcept {
+    histogram_block & b = histogram_block::current();
+    const std::uint64_t now = ticks();
+    if ( 0 != b.last_switch) {
+        add( b.run_slice[histogram_bucket( elapsed( now, b.last_switch) )]);
+    }
+    if ( 0 != to->suspended_at) {
+        add( b.suspended[histogram_bucket( elapsed( now, to->suspended_at) )]);
+    }
+    from->suspended_at = now;
+    b.last_switch = now;
+}
+
+# define BOOST_CONTEXT_HISTOGRAM( from, to) \
+    ::boost::context::detail::record_switch( from, to)
+#else
+// empty base, the disabled build does not touch the switch path
+struct histogram_hook {
+};
+
+# define BOOST_CONTEXT_HISTOGRAM( from, to) ((void)0)
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_HISTOGRAM_H
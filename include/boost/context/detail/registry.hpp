@@ -0,0 +1,99 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_REGISTRY_H
+#define BOOST_CONTEXT_DETAIL_REGISTRY_H
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+// the accounting enumerates the contexts of a thread
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING) && ! defined(BOOST_CONTEXT_USE_REGISTRY)
+# define BOOST_CONTEXT_USE_REGISTRY
+#endif
+
+#if defined(BOOST_CONTEXT_USE_REGISTRY)
+# include <atomic>
+
+# include <boost/context/detail/spinlock.hpp>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+#if defined(BOOST_CONTEXT_USE_REGISTRY)
+struct context_list;
+
+// base of activation_record; links the record into the list of the
+// creating thread
+struct BOOST_CONTEXT_DECL registry_hook {
+    registry_hook           *   prev;
+    registry_hook           *   next;
+    context_list            *   owner;
+    // false while suspended; the saved frames are valid only then
+    std::atomic< bool >         running;
+
+    explicit registry_hook( bool running_) noexcept;
+
+    ~registry_hook();
+
+    registry_hook( registry_hook const&) = delete;
+    registry_hook & operator=( registry_hook const&) = delete;
+};
+
+// live records created by one thread; released lists are recycled by new
+// threads once their records were destroyed
+struct BOOST_CONTEXT_DECL context_list {
+    spinlock                mtx;
+    registry_hook       *   head;
+    // lists are never freed; new lists are pushed at the front
+    context_list        *   nxt;
+    bool                    in_use;
+
+    // list of the calling thread, nullptr before the first record
+    thread_local static context_list    *   current_;
+
+    static context_list * attach() noexcept;
+
+    static context_list * current() noexcept {
+        context_list * l = current_;
+        return nullptr != l ? l : attach();
+    }
+
+    // first list of all threads
+    static context_list * first() noexcept;
+};
+
+inline
+void register_switch( registry_hook * from, registry_hook * to) noexcept {
+    from->running.store( false, std::memory_order_relaxed);
+    to->running.store( true, std::memory_order_relaxed);
+}
+
+# define BOOST_CONTEXT_REGISTER_SWITCH( from, to) \
+    ::boost::context::detail::register_switch( from, to)
+#else
+// empty base, the disabled build does not touch the switch path
+struct registry_hook {
+    explicit registry_hook( bool) noexcept {
+    }
+};
+
+# define BOOST_CONTEXT_REGISTER_SWITCH( from, to) ((void)0)
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_REGISTRY_H
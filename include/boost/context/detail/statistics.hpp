@@ -0,0 +1,74 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_STATISTICS_H
+#define BOOST_CONTEXT_DETAIL_STATISTICS_H
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+# include <atomic>
+# include <cstdint>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+enum stack_kind {
+    stack_fixedsize = 0,
+    stack_protected_fixedsize,
+    stack_segmented,
+    stack_kinds
+};
+
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+// counters of one thread; written only by the owning thread (relaxed
+// load + store, no locked instruction on the switch path), read by
+// aggregate_statistics(); released blocks are recycled by new threads
+struct BOOST_CONTEXT_DECL thread_counters {
+    std::atomic< std::int64_t >     switches;
+    std::atomic< std::int64_t >     creations;
+    std::atomic< std::int64_t >     destructions;
+    std::atomic< std::int64_t >     stack_bytes[stack_kinds];
+    thread_counters             *   nxt;
+    bool                            in_use;
+
+    // counters of the calling thread, nullptr before the first access
+    thread_local static thread_counters *   current_;
+
+    static thread_counters * attach() noexcept;
+
+    static thread_counters & current() noexcept {
+        thread_counters * c = current_;
+        return nullptr != c ? * c : * attach();
+    }
+};
+
+inline
+void count( std::atomic< std::int64_t > & c, std::int64_t d) noexcept {
+    c.store( c.load( std::memory_order_relaxed) + d, std::memory_order_relaxed);
+}
+
+# define BOOST_CONTEXT_COUNT( field, d) \
+    ::boost::context::detail::count( ::boost::context::detail::thread_counters::current().field, d)
+#else
+// the disabled build does not touch the switch path
+# define BOOST_CONTEXT_COUNT( field, d) ((void)0)
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_STATISTICS_H
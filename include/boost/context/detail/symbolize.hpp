@@ -0,0 +1,80 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_SYMBOLIZE_H
+#define BOOST_CONTEXT_DETAIL_SYMBOLIZE_H
+
+#include <cstddef>
+#include <string>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_WINDOWS)
+# include <dlfcn.h>
+#endif
+#if defined(__GNUC__)
+# include <cstdlib>
+
+# include <cxxabi.h>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+struct symbol {
+    // demangled, empty if the address is not covered by a symbol
+    std::string         name;
+    std::size_t         offset;
+    char const      *   module;
+};
+
+// resolves the function containing the code address `addr`; only dynamic
+// symbols are found (link executables with -rdynamic); used by the sources
+// of the library, not async-signal-safe
+inline
+bool symbolize( void * addr, bool return_address, symbol & sym) {
+    sym.name.clear();
+    sym.offset = 0;
+    sym.module = nullptr;
+#if ! defined(BOOST_WINDOWS)
+    Dl_info info;
+    // a return address might point behind the last instruction of the caller
+    if ( 0 == ::dladdr( return_address ? static_cast< char * >( addr) - 1 : addr, & info) ) {
+        return false;
+    }
+    sym.module = info.dli_fname;
+    if ( nullptr != info.dli_sname) {
+        sym.name = info.dli_sname;
+# if defined(__GNUC__)
+        int status = 0;
+        char * demangled = abi::__cxa_demangle( info.dli_sname, nullptr, nullptr, & status);
+        if ( 0 == status && nullptr != demangled) {
+            sym.name = demangled;
+        }
+        std::free( demangled);
+# endif
+        sym.offset = static_cast< std::size_t >(
+                static_cast< char * >( addr) - static_cast< char * >( info.dli_saddr) );
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_SYMBOLIZE_H
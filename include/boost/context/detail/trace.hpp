@@ -0,0 +1,106 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_TRACE_H
+#define BOOST_CONTEXT_DETAIL_TRACE_H
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(BOOST_CONTEXT_USE_TRACE)
+# include <atomic>
+# include <cstddef>
+# include <cstdint>
+
+# include <boost/context/detail/clock.hpp>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+#if defined(BOOST_CONTEXT_USE_TRACE)
+// events per thread, power of two
+# if ! defined(BOOST_CONTEXT_TRACE_EVENTS)
+#  define BOOST_CONTEXT_TRACE_EVENTS 65536
+# endif
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+#if defined(BOOST_CONTEXT_USE_TRACE)
+static_assert( 0 == ( BOOST_CONTEXT_TRACE_EVENTS & ( BOOST_CONTEXT_TRACE_EVENTS - 1) ),
+               "BOOST_CONTEXT_TRACE_EVENTS must be a power of two");
+
+// one context switch; the fields are atomic only because the exporter
+// might read a slot while it is overwritten (relaxed, plain moves)
+struct trace_event {
+    std::atomic< std::uint64_t >    ts;
+    std::atomic< void const* >      from;
+    std::atomic< void const* >      to;
+    std::atomic< char const* >      name;
+};
+
+// ring of the most recent switches of one thread; written only by the
+// owning thread, read by write_trace(); released buffers are recycled
+// by new threads
+struct BOOST_CONTEXT_DECL trace_buffer {
+    // number of events ever recorded; slot is head % BOOST_CONTEXT_TRACE_EVENTS
+    std::atomic< std::uint64_t >    head;
+    // events before `base` were discarded by trace_clear()
+    std::atomic< std::uint64_t >    base;
+    trace_event                     events[BOOST_CONTEXT_TRACE_EVENTS];
+    std::uint32_t                   tid;
+    trace_buffer                *   nxt;
+    bool                            in_use;
+
+    static std::atomic< bool >              enabled_;
+    // buffer of the calling thread, nullptr before the first switch
+    thread_local static trace_buffer    *   current_;
+
+    static trace_buffer * attach() noexcept;
+
+    static trace_buffer * current() noexcept {
+        trace_buffer * b = current_;
+        return nullptr != b ? b : attach();
+    }
+};
+
+inline
+void trace( void const* from, void const* to, char const* name) noexcept {
+    if ( ! trace_buffer::enabled_.load( std::memory_order_relaxed) ) {
+        return;
+    }
+    trace_buffer * b = trace_buffer::current();
+    if ( BOOST_UNLIKELY( nullptr == b) ) {
+        return;
+    }
+    const std::uint64_t h = b->head.load( std::memory_order_relaxed);
+    trace_event & e = b->events[h & ( BOOST_CONTEXT_TRACE_EVENTS - 1)];
+    e.ts.store( ticks(), std::memory_order_relaxed);
+    e.from.store( from, std::memory_order_relaxed);
+    e.to.store( to, std::memory_order_relaxed);
+    e.name.store( name, std::memory_order_relaxed);
+    // publishes the event
+    b->head.store( h + 1, std::memory_order_release);
+}
+
+# define BOOST_CONTEXT_TRACE( from, to, name) \
+    ::boost::context::detail::trace( from, to, name)
+#else
+// the disabled build does not touch the switch path
+# define BOOST_CONTEXT_TRACE( from, to, name) ((void)0)
+#endif
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_TRACE_H
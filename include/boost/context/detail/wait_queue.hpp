@@ -0,0 +1,142 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_DETAIL_WAIT_QUEUE_H
+#define BOOST_CONTEXT_DETAIL_WAIT_QUEUE_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <atomic>
+# include <chrono>
+
+# include <boost/config.hpp>
+
+# include <boost/context/detail/futex.hpp>
+# include <boost/context/detail/spinlock.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+struct task_record;
+class wait_queue;
+
+// a context (or a thread not running a scheduler) blocked on a
+// synchronization primitive; lives on the stack of the waiting party
+struct BOOST_CONTEXT_DECL waiter {
+    // nullptr if a plain thread waits
+    task_record         *   task;
+    // set by wake() for a plain thread
+    futex_type              state;
+    waiter              *   prev;
+    waiter              *   next;
+    // queue `this` is linked into, nullptr if not linked
+    wait_queue          *   queue;
+    // lock of the primitive, required by the timeout
+    spinlock            *   splk;
+    // shared by the waiters of one select(), the first party
+    // claiming it completes the select; nullptr otherwise
+    std::atomic< waiter * > *   selected;
+
+    // captures the running context of the calling thread
+    waiter() noexcept;
+
+    bool claim() noexcept {
+        waiter * expected = nullptr;
+        return nullptr == selected ||
+               selected->compare_exchange_strong( expected, this, std::memory_order_acq_rel);
+    }
+
+    waiter( waiter const&) = delete;
+    waiter & operator=( waiter const&) = delete;
+};
+
+// FIFO of waiters, protected by the spinlock of the owning primitive
+class BOOST_CONTEXT_DECL wait_queue {
+private:
+    waiter  *   head_;
+    waiter  *   tail_;
+
+    static bool expire_( void * vp) noexcept;
+
+public:
+    wait_queue() noexcept :
+        head_( nullptr),
+        tail_( nullptr) {
+    }
+
+    wait_queue( wait_queue const&) = delete;
+    wait_queue & operator=( wait_queue const&) = delete;
+
+    bool empty() const noexcept {
+        return nullptr == head_;
+    }
+
+    void push_back( waiter * w) noexcept;
+
+    // unlinks the first waiter that can be claimed; waiters of a
+    // select() completed by another party are dropped
+    waiter * pop_front() noexcept;
+
+    // unlink all waiters, returns the claimed ones chained via `next`
+    waiter * pop_all() noexcept;
+
+    void remove( waiter * w) noexcept;
+
+    // `w` was pushed while holding `lk`; releases `lk` and suspends the
+    // running context (blocks the thread) until wake() was called for `w`
+    // returns false if `deadline` was reached, `w` is removed in this case
+    // `lk` is nullptr for primitives restricted to one thread
+    static bool suspend( spinlock * lk, waiter & w,
+                         std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max() ) noexcept;
+
+    // suspend the running context as blocked on a synchronization primitive,
+    // see scheduler::suspend_until()
+    static bool park( std::chrono::steady_clock::time_point deadline,
+                      bool (* fn)( void *), void * vp) noexcept;
+
+    // `w` was popped while holding the lock of its queue;
+    // must be called after the lock is released
+    static void wake( waiter * w) noexcept;
+
+    // wake a chain returned by pop_all()
+    static void wake_all( waiter * w) noexcept;
+
+    // called by a primitive that completed without suspending; yields if
+    // the running context exceeded its time slice (scheduler::time_slice())
+    static void checkpoint() noexcept;
+};
+
+template< typename Clock, typename Duration >
+std::chrono::steady_clock::time_point
+to_steady( std::chrono::time_point< Clock, Duration > const& tp) {
+    if ( ( std::chrono::time_point< Clock, Duration >::max)() == tp) {
+        return ( std::chrono::steady_clock::time_point::max)();
+    }
+    return std::chrono::steady_clock::now() +
+        std::chrono::duration_cast< std::chrono::steady_clock::duration >( tp - Clock::now() );
+}
+
+inline
+std::chrono::steady_clock::time_point
+to_steady( std::chrono::steady_clock::time_point const& tp) {
+    return tp;
+}
+
+}}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_DETAIL_WAIT_QUEUE_H
@@ -13,9 +13,11 @@
 
 # include <algorithm>
 # include <atomic>
+# include <chrono>
 # include <cstddef>
 # include <cstdint>
 # include <cstdlib>
+# include <exception>
 # include <functional>
 # include <memory>
 # include <ostream>
@@ -27,7 +29,15 @@
 # include <boost/context/fcontext.hpp>
 # include <boost/intrusive_ptr.hpp>
 
+# include <boost/context/cancellation.hpp>
+
+# include <boost/context/detail/accounting.hpp>
+# include <boost/context/detail/fls.hpp>
+# include <boost/context/detail/histogram.hpp>
 # include <boost/context/detail/invoke.hpp>
+# include <boost/context/detail/registry.hpp>
+# include <boost/context/detail/statistics.hpp>
+# include <boost/context/detail/trace.hpp>
 # include <boost/context/fixedsize_stack.hpp>
 # include <boost/context/stack_context.hpp>
 # include <boost/context/segmented_stack.hpp>
@@ -50,12 +60,23 @@ namespace boost {
 namespace context {
 namespace detail {
 
-struct activation_record {
+struct activation_record : public registry_hook, public accounting_hook, public histogram_hook {
     typedef boost::intrusive_ptr< activation_record >    ptr_t;
 
     enum flag_t {
         flag_main_ctx   = 1 << 1,
-        flag_preserve_fpu = 1 << 2
+        flag_preserve_fpu = 1 << 2,
+        // a cancellation token is attached
+        flag_cancellable = 1 << 3,
+        // destroyed while suspended, unwinds at its next suspension point
+        flag_force_unwind = 1 << 4,
+        // forced_unwind has been thrown
+        flag_unwinding = 1 << 5,
+        // the context-function has been left, the context is never resumed
+        flag_finished = 1 << 6,
+        // a context resumed by this context has emitted an exception, it is
+        // rethrown on return from execution_context::operator()
+        flag_rethrow = 1 << 7
     };
 
     thread_local static ptr_t   current_rec;
@@ -63,33 +84,70 @@ struct activation_record {
     std::atomic< std::size_t >  use_count;
     fcontext_t                  fctx;
     stack_context               sctx;
+    // context-local storage (context_specific_ptr<>), cleaned up
+    // by the destructor
+    fls_table                   fls;
+    // name shown by diagnostics (trace), not owned
+    char const              *   name;
+    // context that resumed this context for the last time without returning
+    // to it (caller); resumed after the stack has been unwound or the
+    // context-function has emitted an exception
+    activation_record       *   resumer;
+    boost::intrusive_ptr< cancellation_state >  cancel;
+    // exception to be rethrown, see flag_rethrow
+    std::exception_ptr          except;
     int                         flags;
 
     // used for toplevel-context
     // (e.g. main context, thread-entry context)
     activation_record() noexcept :
+        registry_hook( true),
         use_count( 0),
         fctx( nullptr),
         sctx(),
+        fls(),
+        name( nullptr),
+        resumer( nullptr),
+        cancel(),
+        except(),
         flags( flag_main_ctx) {
     } 
 
     activation_record( fcontext_t fctx_, stack_context sctx_) noexcept :
+        registry_hook( false),
         use_count( 0),
         fctx( fctx_),
         sctx( sctx_),
+        fls(),
+        name( nullptr),
+        resumer( nullptr),
+        cancel(),
+        except(),
         flags( 0) {
     } 
 
     virtual ~activation_record() noexcept = default;
 
     void * resume( void * vp, bool fpu) noexcept {
-        // store current activation record in local variable
-        activation_record * from = current_rec.get();
+        return resume( current_rec.get(), vp, fpu);
+    }
+
+    // `from` is the running context (current_rec)
+    void * resume( activation_record * from, void * vp, bool fpu) noexcept {
+        BOOST_CONTEXT_COUNT( switches, 1);
+        BOOST_CONTEXT_TRACE( from, this, name);
+        BOOST_CONTEXT_ACCOUNT( from, this);
+        BOOST_CONTEXT_HISTOGRAM( from, this);
+        BOOST_CONTEXT_REGISTER_SWITCH( from, this);
         // store `this` in static, thread local pointer
         // `this` will become the active (running) context
         // returned by execution_context::current()
         current_rec = this;
+        // a context returning control to the context that resumed it
+        // (e.g. a finished context) does not replace the resumer
+        if ( BOOST_LIKELY( from->resumer != this) ) {
+            resumer = from;
+        }
         // set FPU flag
         if (fpu) {
             from->flags |= flag_preserve_fpu;
@@ -109,6 +167,46 @@ struct activation_record {
         return reinterpret_cast< void * >( ret);
     }
 
+    // resume() for execution_context::operator(); the flags of the running
+    // context are tested once control has returned to it
+    void * call( void * vp, bool fpu) {
+        activation_record * from = current_rec.get();
+        void * ret = resume( from, vp, fpu);
+        if ( BOOST_UNLIKELY( 0 != ( from->flags & ( flag_cancellable | flag_force_unwind | flag_rethrow) ) ) ) {
+            unwind( from);
+        }
+        return ret;
+    }
+
+    // rethrows the exception emitted by a context resumed by the running
+    // context; throws forced_unwind once if the running context has been
+    // cancelled or destroyed, the main context is never unwound
+    static void unwind_point() {
+        activation_record * ar = current_rec.get();
+        if ( BOOST_LIKELY( 0 == ( ar->flags & ( flag_cancellable | flag_force_unwind | flag_rethrow) ) ) ) {
+            return;
+        }
+        unwind( ar);
+    }
+
+    // slow path of unwind_point(), `ar` is the running context
+    BOOST_NOINLINE static void unwind( activation_record * ar) {
+        if ( 0 != ( ar->flags & flag_rethrow) ) {
+            ar->flags &= ~flag_rethrow;
+            std::exception_ptr except;
+            std::swap( except, ar->except);
+            std::rethrow_exception( except);
+        }
+        if ( 0 != ( ar->flags & ( flag_main_ctx | flag_unwinding) ) ) {
+            return;
+        }
+        if ( 0 != ( ar->flags & flag_force_unwind) ||
+             ar->cancel->requested.load( std::memory_order_relaxed) ) {
+            ar->flags |= flag_unwinding;
+            throw forced_unwind();
+        }
+    }
+
     virtual void deallocate() {
         delete this;
     }
@@ -144,6 +242,7 @@ private:
         stack_context sctx( p->sctx);
         // deallocate activation record
         p->~capture_record();
+        BOOST_CONTEXT_COUNT( destructions, 1);
         // destroy stack with stack allocator
         salloc.deallocate( sctx);
     }
@@ -159,20 +258,56 @@ public:
         fn_( std::forward< Fn >( fn) ),
         tpl_( std::forward< Tpl >( tpl) ),
         caller_( caller) {
+        BOOST_CONTEXT_COUNT( creations, 1);
     }
 
     void deallocate() override final {
+        if ( 0 == ( flags & flag_finished) && current_rec) {
+            // resumed to unwind its stack, returns once the context-function
+            // has been left; the temporary reference keeps the record alive
+            // while it runs
+            use_count = 1;
+            flags |= flag_force_unwind;
+            // returns to the destroying context
+            activation_record * from = current_rec.get();
+            resumer = from;
+            resume( nullptr, false);
+            // a context swallowing forced_unwind and suspending again is
+            // released without further unwinding; an exception emitted
+            // while unwinding is discarded
+            if ( 0 != ( from->flags & flag_rethrow) ) {
+                from->flags &= ~flag_rethrow;
+                from->except = nullptr;
+            }
+        }
         destroy( this);
     }
 
     void run() noexcept {
+        // captured inside the handler, the context is left outside of it
+        std::exception_ptr except;
         try {
             void * vp = caller_->resume( caller_, true);
+            // cancelled or destroyed before the first resumption
+            unwind_point();
             do_invoke( fn_, std::tuple_cat( tpl_, std::tie( vp) ) );
+        } catch ( forced_unwind const&) {
         } catch (...) {
-            std::terminate();
+            except = std::current_exception();
         }
         BOOST_ASSERT( 0 == (flags & flag_main_ctx) );
+        if ( except) {
+            // rethrown by the context resumed below on return from
+            // execution_context::operator()
+            resumer->except = std::move( except);
+            resumer->flags |= flag_rethrow;
+        } else if ( 0 == ( flags & flag_unwinding) ) {
+            return;
+        }
+        // the stack has been unwound, return to the caller
+        flags |= flag_finished;
+        resumer->resume( nullptr, false);
+        BOOST_ASSERT_MSG( false, "finished context resumed");
     }
 };
 
@@ -190,6 +325,8 @@ struct preallocated {
 
 class BOOST_CONTEXT_DECL execution_context {
 private:
+    friend class scheduler;
+
     // tampoline function
     // entered if the execution context
     // is resumed for the first time
@@ -278,6 +415,40 @@ private:
         ptr_( detail::activation_record::current_rec) {
     }
 
+    // switch without cancellation check, used by the scheduler whose
+    // suspension points check after their bookkeeping
+    void * resume_( void * vp = nullptr) noexcept {
+        return ptr_->resume( vp, false);
+    }
+
+    // the context-function will not return, the context must not be unwound
+    void finish_() noexcept {
+        ptr_->flags |= detail::activation_record::flag_finished;
+    }
+
+    // forced_unwind is thrown when the context is resumed next
+    void force_unwind_() noexcept {
+        ptr_->flags |= detail::activation_record::flag_force_unwind;
+    }
+
+    bool forced_unwind_() const noexcept {
+        return 0 != ( ptr_->flags & detail::activation_record::flag_force_unwind);
+    }
+
+    bool finished_() const noexcept {
+        return 0 != ( ptr_->flags & detail::activation_record::flag_finished);
+    }
+
+    // requests the cancellation of the attached token, a token is
+    // attached if there is none
+    void cancel_() {
+        if ( ! ptr_->cancel) {
+            ptr_->cancel.reset( new detail::cancellation_state() );
+            ptr_->flags |= detail::activation_record::flag_cancellable;
+        }
+        ptr_->cancel->requested.store( true, std::memory_order_relaxed);
+    }
+
 public:
     static execution_context current() noexcept;
 
@@ -385,8 +556,53 @@ public:
         return * this;
     }
 
-    void * operator()( void * vp = nullptr, bool preserve_fpu = false) noexcept {
-        return ptr_->resume( vp, preserve_fpu);
+    // throws forced_unwind on return if the running context has been
+    // cancelled; rethrows the exception emitted by the function of `*this`
+    // (or of another context called by the running context)
+    void * operator()( void * vp = nullptr, bool preserve_fpu = false) {
+        return ptr_->call( vp, preserve_fpu);
+    }
+
+    // the context observes the cancellation of `token` at its suspension
+    // points (operator() and the suspension points of scheduler)
+    void cancellation( cancellation_token const& token) noexcept {
+        ptr_->cancel = token.state_;
+        ptr_->flags |= detail::activation_record::flag_cancellable;
+    }
+
+    // the attached token, a new one is attached if there is none
+    cancellation_token cancellation() {
+        if ( ! ptr_->cancel) {
+            cancellation( cancellation_token() );
+        }
+        return cancellation_token( ptr_->cancel.get() );
+    }
+
+    // `n` must outlive the context (e.g. a string literal)
+    void name( char const* n) noexcept {
+        ptr_->name = n;
+    }
+
+    char const* name() const noexcept {
+        return ptr_->name;
+    }
+
+    // zero unless built with BOOST_CONTEXT_USE_ACCOUNTING
+    std::chrono::nanoseconds cpu_time() const noexcept {
+# if defined(BOOST_CONTEXT_USE_ACCOUNTING)
+        return detail::ticks_to_ns(
+                detail::run_ticks( ptr_.get(), ptr_ == detail::activation_record::current_rec) );
+# else
+        return std::chrono::nanoseconds::zero();
+# endif
+    }
+
+    std::uint64_t resumes() const noexcept {
+# if defined(BOOST_CONTEXT_USE_ACCOUNTING)
+        return ptr_->resumes.load( std::memory_order_relaxed);
+# else
+        return 0;
+# endif
     }
 
     explicit operator bool() const noexcept {
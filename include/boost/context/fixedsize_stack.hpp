@@ -15,6 +15,7 @@
 #include <boost/config.hpp>
 
 #include <boost/context/detail/config.hpp>
+#include <boost/context/detail/statistics.hpp>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
 
@@ -57,6 +58,7 @@ public:
 #if defined(BOOST_USE_VALGRIND)
         sctx.valgrind_stack_id = VALGRIND_STACK_REGISTER( sctx.sp, vp);
 #endif
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_fixedsize], static_cast< std::int64_t >( sctx.size) );
         return sctx;
     }
 
@@ -71,6 +73,7 @@ public:
         VALGRIND_STACK_DEREGISTER( sctx.valgrind_stack_id);
 #endif
 
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_fixedsize], -static_cast< std::int64_t >( sctx.size) );
         void * vp = static_cast< char * >( sctx.sp) - sctx.size;
         std::free( vp);
     }
@@ -0,0 +1,109 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_HISTOGRAM_H
+#define BOOST_CONTEXT_HISTOGRAM_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+#include <boost/context/detail/histogram.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+// log-linear (HDR-style) histogram of durations in nanoseconds; values are
+// counted with a relative error below 1/32
+class BOOST_CONTEXT_DECL latency_histogram {
+public:
+    static constexpr std::size_t buckets = detail::histogram_buckets;
+
+    latency_histogram() noexcept;
+
+    void record( std::chrono::nanoseconds d, std::uint64_t n = 1) noexcept;
+
+    // merges the counts of `other`
+    latency_histogram & operator+=( latency_histogram const& other) noexcept;
+
+    void clear() noexcept;
+
+    std::uint64_t count() const noexcept {
+        return total_;
+    }
+
+    std::uint64_t count( std::size_t bucket) const noexcept {
+        return counts_[bucket];
+    }
+
+    // the values counted by `bucket`
+    static std::chrono::nanoseconds lower_bound( std::size_t bucket) noexcept;
+    static std::chrono::nanoseconds upper_bound( std::size_t bucket) noexcept;
+
+    // results are the bounds of the buckets, zero if the histogram is empty
+    std::chrono::nanoseconds min() const noexcept;
+    std::chrono::nanoseconds max() const noexcept;
+    std::chrono::nanoseconds mean() const noexcept;
+
+    // smallest value not exceeded by `p` percent of the values (upper bound
+    // of its bucket), 0 <= p <= 100
+    std::chrono::nanoseconds percentile( double p) const noexcept;
+
+    // count, min, mean, max and the percentiles 50 ... 99.99 in microseconds
+    void write_text( std::ostream & os) const;
+
+    // {"count":..,"min_ns":..,"mean_ns":..,"max_ns":..,"percentiles":{..},
+    //  "buckets":[[lower_ns,upper_ns,count],..]}, non-empty buckets only
+    void write_json( std::ostream & os) const;
+
+private:
+    std::uint64_t   total_;
+    std::uint64_t   counts_[buckets];
+};
+
+// maintained only if the library was built with
+// BOOST_CONTEXT_USE_HISTOGRAMS (histograms=on), empty otherwise
+struct switch_histograms {
+    // time a context ran until it switched to another context
+    latency_histogram   run_slice;
+    // time a context was suspended until it was resumed
+    latency_histogram   suspended;
+
+    switch_histograms & operator+=( switch_histograms const& other) noexcept {
+        run_slice += other.run_slice;
+        suspended += other.suspended;
+        return * this;
+    }
+};
+
+// histograms of the calling thread
+BOOST_CONTEXT_DECL switch_histograms thread_histograms();
+
+// merged histograms of all threads, including terminated threads
+BOOST_CONTEXT_DECL switch_histograms aggregate_histograms();
+
+// discards the counts of all threads
+BOOST_CONTEXT_DECL void reset_histograms() noexcept;
+
+BOOST_CONTEXT_DECL void write_text( std::ostream & os, switch_histograms const& h);
+
+// {"run_slice":{..},"suspended":{..}}
+BOOST_CONTEXT_DECL void write_json( std::ostream & os, switch_histograms const& h);
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_HISTOGRAM_H
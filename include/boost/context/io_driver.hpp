@@ -0,0 +1,121 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_IO_DRIVER_H
+#define BOOST_CONTEXT_IO_DRIVER_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT) && ! defined(BOOST_WINDOWS)
+
+extern "C" {
+#include <sys/socket.h>
+#include <sys/types.h>
+}
+
+# include <cstddef>
+# include <memory>
+
+# include <boost/config.hpp>
+
+# include <boost/context/scheduler.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+// request issued by a suspended context;
+// lives on the stack of the issuing context
+struct io_op {
+    enum code_t {
+        code_read = 0,
+        code_write,
+        code_accept,
+        code_fsync
+    };
+
+    code_t                  code;
+    int                     fd;
+    void                *   buf;
+    std::size_t             len;
+    off_t                   offset;
+    socklen_t           *   addrlen;
+    task_handle             task;
+    // result of the request, negative errno on failure
+    long                    result;
+};
+
+class io_backend;
+
+}
+
+// performs file and socket I/O on behalf of the contexts of a scheduler;
+// the issuing context is suspended until its request completes
+class BOOST_CONTEXT_DECL io_driver : public scheduler::poller {
+public:
+    enum backend_t {
+        // io_uring if the kernel supports it, thread-pool otherwise
+        backend_auto = 0,
+        backend_io_uring,
+        backend_thread_pool
+    };
+
+private:
+    scheduler                               &   sched_;
+    std::unique_ptr< detail::io_backend >       impl_;
+    backend_t                                   backend_;
+    std::size_t                                 inflight_;
+
+    long submit_( detail::io_op &) noexcept;
+
+public:
+    explicit io_driver( scheduler & sched, backend_t backend = backend_auto,
+                        unsigned int entries = 256, std::size_t threads = 4);
+
+    ~io_driver();
+
+    io_driver( io_driver const&) = delete;
+    io_driver & operator=( io_driver const&) = delete;
+
+    backend_t backend() const noexcept {
+        return backend_;
+    }
+
+    // offset -1 reads/writes at the current file position
+    ssize_t read( int fd, void * buf, std::size_t len, off_t offset = -1) noexcept;
+
+    ssize_t write( int fd, void const* buf, std::size_t len, off_t offset = -1) noexcept;
+
+    int accept( int fd, sockaddr * addr = nullptr, socklen_t * addrlen = nullptr) noexcept;
+
+    int fsync( int fd) noexcept;
+
+    void poll() override;
+
+    void wait( scheduler::clock_type::time_point deadline) override;
+
+    bool busy() const noexcept override {
+        return 0 < inflight_;
+    }
+
+    void notify() noexcept override;
+
+    // called by the backends for each finished request
+    void complete( detail::io_op * op) noexcept;
+};
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_IO_DRIVER_H
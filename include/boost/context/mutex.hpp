@@ -0,0 +1,74 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_MUTEX_H
+#define BOOST_CONTEXT_MUTEX_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <chrono>
+
+# include <boost/config.hpp>
+
+# include <boost/context/detail/spinlock.hpp>
+# include <boost/context/detail/wait_queue.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+// suspends the waiting context instead of blocking the thread;
+// contexts of other threads (and plain threads) block on a futex
+// waiters acquire the mutex in FIFO order, unlock() hands the
+// ownership directly to the first waiter
+class BOOST_CONTEXT_DECL mutex {
+private:
+    detail::spinlock        splk_;
+    bool                    locked_;
+    detail::wait_queue      waiters_;
+
+    bool lock_( std::chrono::steady_clock::time_point deadline) noexcept;
+
+public:
+    mutex() noexcept;
+
+    ~mutex();
+
+    mutex( mutex const&) = delete;
+    mutex & operator=( mutex const&) = delete;
+
+    void lock() noexcept {
+        lock_( std::chrono::steady_clock::time_point::max() );
+    }
+
+    bool try_lock() noexcept;
+
+    template< typename Clock, typename Duration >
+    bool try_lock_until( std::chrono::time_point< Clock, Duration > const& tp) noexcept {
+        return lock_( detail::to_steady( tp) );
+    }
+
+    template< typename Rep, typename Period >
+    bool try_lock_for( std::chrono::duration< Rep, Period > const& d) noexcept {
+        return try_lock_until( std::chrono::steady_clock::now() + d);
+    }
+
+    void unlock() noexcept;
+};
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_MUTEX_H
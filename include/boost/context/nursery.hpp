@@ -0,0 +1,266 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_NURSERY_H
+#define BOOST_CONTEXT_NURSERY_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <cstddef>
+# include <exception>
+# include <memory>
+# include <new>
+# include <utility>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# include <boost/context/cancellation.hpp>
+# include <boost/context/detail/invoke.hpp>
+# include <boost/context/execution_context.hpp>
+# include <boost/context/fixedsize_stack.hpp>
+# include <boost/context/scheduler.hpp>
+# include <boost/context/segmented_stack.hpp>
+# include <boost/context/stack_context.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+// caches the stacks of terminated children; a cached stack keeps its link
+// in its own (unused) memory, caching does not allocate
+template< typename StackAlloc >
+class stack_pool {
+private:
+    struct node {
+        stack_context   sctx;
+        node        *   nxt;
+    };
+
+    StackAlloc      salloc_;
+    node        *   free_;
+
+public:
+    explicit stack_pool( StackAlloc const& salloc) :
+        salloc_( salloc),
+        free_( nullptr) {
+    }
+
+    ~stack_pool() {
+        release();
+    }
+
+    stack_pool( stack_pool const&) = delete;
+    stack_pool & operator=( stack_pool const&) = delete;
+
+    stack_context allocate() {
+        if ( nullptr == free_) {
+            return salloc_.allocate();
+        }
+        node * n = free_;
+        free_ = n->nxt;
+        return n->sctx;
+    }
+
+    void deallocate( stack_context & sctx) noexcept {
+        void * vp = static_cast< char * >( sctx.sp) - sizeof( node);
+        free_ = ::new ( vp) node{ sctx, free_ };
+    }
+
+    // returns the cached stacks to the stack allocator
+    void release() noexcept {
+        while ( nullptr != free_) {
+            stack_context sctx( free_->sctx);
+            free_ = free_->nxt;
+            salloc_.deallocate( sctx);
+        }
+    }
+};
+
+// stack allocator handed to the scheduler, refers to the pool of a nursery
+template< typename StackAlloc >
+class pooled_stack {
+private:
+    stack_pool< StackAlloc >    *   pool_;
+
+public:
+    explicit pooled_stack( stack_pool< StackAlloc > * pool) noexcept :
+        pool_( pool) {
+    }
+
+    stack_context allocate() {
+        return pool_->allocate();
+    }
+
+    void deallocate( stack_context & sctx) noexcept {
+        pool_->deallocate( sctx);
+    }
+};
+
+}
+
+// fork/join of child contexts on the scheduler running on the calling
+// thread; the children can not outlive the nursery, their stacks are
+// recycled by later children and returned to `StackAlloc` when all children
+// have been joined
+template< typename StackAlloc = default_stack >
+class basic_nursery {
+private:
+    // a running child; lives on the stack of the child
+    struct child {
+        detail::task_record     *   task;
+        child                   *   prev;
+        child                   *   nxt;
+    };
+
+    scheduler                       *   sched_;
+    detail::stack_pool< StackAlloc >    pool_;
+    // children not yet terminated
+    std::size_t                         pending_;
+    // context suspended in join()
+    detail::task_record             *   joiner_;
+    // first exception emitted by a child
+    std::exception_ptr                  except_;
+    // attached to all children
+    cancellation_token                  token_;
+    // children entered their function and not yet terminated
+    child                           *   running_;
+
+    template< typename Fn, typename ... Args >
+    void run_( Fn & fn, Args && ... args) noexcept {
+        // children not started before the cancellation are skipped
+        if ( ! token_.cancelled() ) {
+            execution_context::current().cancellation( token_);
+            child c = { sched_->running_, nullptr, running_ };
+            if ( nullptr != running_) {
+                running_->prev = & c;
+            }
+            running_ = & c;
+            try {
+                detail::invoke( fn, std::forward< Args >( args) ... );
+            } catch ( forced_unwind const&) {
+                // cancelled, the stack has been unwound
+            } catch (...) {
+                if ( ! except_) {
+                    except_ = std::current_exception();
+                }
+                cancel();
+            }
+            if ( nullptr != c.prev) {
+                c.prev->nxt = c.nxt;
+            } else {
+                running_ = c.nxt;
+            }
+            if ( nullptr != c.nxt) {
+                c.nxt->prev = c.prev;
+            }
+        }
+        if ( 0 == --pending_ && nullptr != joiner_) {
+            detail::task_record * t = joiner_;
+            joiner_ = nullptr;
+            sched_->ready_( t);
+        }
+    }
+
+    void wait_() noexcept {
+        BOOST_ASSERT( 0 == pending_ || nullptr != sched_->running_);
+        while ( 0 < pending_) {
+            joiner_ = sched_->running_;
+            // not a cancellation point, the children have to be joined
+            sched_->suspend_();
+        }
+        // terminated children have been destroyed by the time the joining
+        // context is resumed
+        pool_.release();
+    }
+
+public:
+    explicit basic_nursery( StackAlloc salloc = StackAlloc() ) :
+        sched_( scheduler::current() ),
+        pool_( salloc),
+        pending_( 0),
+        joiner_( nullptr),
+        except_(),
+        token_(),
+        running_( nullptr) {
+        BOOST_ASSERT( nullptr != sched_);
+    }
+
+    // cancels and joins the children still running; an exception not
+    // rethrown by join() is discarded
+    ~basic_nursery() {
+        if ( 0 < pending_) {
+            cancel();
+            wait_();
+        }
+    }
+
+    basic_nursery( basic_nursery const&) = delete;
+    basic_nursery & operator=( basic_nursery const&) = delete;
+
+    template< typename Fn, typename ... Args >
+    void spawn( Fn && fn, Args && ... args) {
+        spawn( task_attributes(), std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+
+    template< typename Fn, typename ... Args >
+    void spawn( task_attributes attrs, Fn && fn, Args && ... args) {
+        sched_->spawn( attrs, std::allocator_arg, detail::pooled_stack< StackAlloc >( & pool_),
+                       [this,fn=std::forward< Fn >( fn)] ( auto && ... a) mutable {
+                           run_( fn, std::forward< decltype( a) >( a) ... );
+                       },
+                       std::forward< Args >( args) ... );
+        ++pending_;
+    }
+
+    // suspends the running context until all children have terminated;
+    // rethrows the first exception emitted by a child
+    void join() {
+        wait_();
+        if ( except_) {
+            std::exception_ptr except;
+            std::swap( except, except_);
+            std::rethrow_exception( except);
+        }
+    }
+
+    // children not yet started are skipped, running children are unwound
+    // (forced_unwind) at their next suspension point; sleeping children and
+    // children waiting with a deadline are woken immediately; called by the
+    // first exception of a child
+    void cancel() noexcept {
+        token_.cancel();
+        for ( child * c = running_; nullptr != c; c = c->nxt) {
+            sched_->interrupt_( c->task);
+        }
+    }
+
+    bool cancelled() const noexcept {
+        return token_.cancelled();
+    }
+
+    // children not yet terminated
+    std::size_t size() const noexcept {
+        return pending_;
+    }
+};
+
+typedef basic_nursery<> nursery;
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_NURSERY_H
@@ -22,6 +22,7 @@ extern "C" {
 #include <boost/config.hpp>
 
 #include <boost/context/detail/config.hpp>
+#include <boost/context/detail/statistics.hpp>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
 
@@ -83,6 +84,7 @@ public:
 #if defined(BOOST_USE_VALGRIND)
         sctx.valgrind_stack_id = VALGRIND_STACK_REGISTER( sctx.sp, vp);
 #endif
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_protected_fixedsize], static_cast< std::int64_t >( sctx.size) );
         return sctx;
     }
 
@@ -95,6 +97,7 @@ public:
         VALGRIND_STACK_DEREGISTER( sctx.valgrind_stack_id);
 #endif
 
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_protected_fixedsize], -static_cast< std::int64_t >( sctx.size) );
         void * vp = static_cast< char * >( sctx.sp) - sctx.size;
         // conform to POSIX.4 (POSIX.1b-1993, _POSIX_C_SOURCE=199309L)
         ::munmap( vp, sctx.size);
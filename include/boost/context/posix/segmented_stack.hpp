@@ -13,6 +13,7 @@
 #include <boost/config.hpp>
 
 #include <boost/context/detail/config.hpp>
+#include <boost/context/detail/statistics.hpp>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
 
@@ -62,10 +63,12 @@ public:
         int off = 0;
         __splitstack_block_signals_context( sctx.segments_ctx, & off, 0);
 
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_segmented], static_cast< std::int64_t >( sctx.size) );
         return sctx;
     }
 
     void deallocate( stack_context & sctx) {
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_segmented], -static_cast< std::int64_t >( sctx.size) );
         __splitstack_releasecontext( sctx.segments_ctx);
     }
 };
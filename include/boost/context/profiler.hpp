@@ -0,0 +1,56 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_PROFILER_H
+#define BOOST_CONTEXT_PROFILER_H
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+// samples the calling thread each time it consumed `interval` of CPU time
+// (SIGPROF); each sample records the running context and its frame-pointer
+// chain
+//
+// available only if the library was built with BOOST_CONTEXT_USE_PROFILER
+// (profiler=on) on x86_64 Linux, returns false otherwise; throws
+// std::system_error if the timer can not be created
+BOOST_CONTEXT_DECL bool profiler_start( std::chrono::microseconds interval = std::chrono::microseconds( 1000) );
+
+// stops sampling the calling thread; the samples are kept
+BOOST_CONTEXT_DECL void profiler_stop() noexcept;
+
+// discards the samples of all threads
+BOOST_CONTEXT_DECL void profiler_clear() noexcept;
+
+// number of samples of all threads; samples taken while the buffer of a
+// thread was full are counted as dropped
+BOOST_CONTEXT_DECL std::size_t profiler_samples() noexcept;
+
+BOOST_CONTEXT_DECL std::size_t profiler_dropped() noexcept;
+
+// writes the samples of all threads aggregated as collapsed stacks: one line
+// per distinct stack, "context;outermost;...;innermost count", the input
+// format of flamegraph.pl; the names of the contexts must still be valid
+BOOST_CONTEXT_DECL void write_profile( std::ostream & os);
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_PROFILER_H
@@ -0,0 +1,51 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_REGISTRY_H
+#define BOOST_CONTEXT_REGISTRY_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+struct context_backtrace {
+    // identifies the context (address of its control structure)
+    void const*             id;
+    char const*             name;
+    // the frames of a running context are not available
+    bool                    running;
+    // return addresses, innermost first
+    std::vector< void * >   frames;
+};
+
+// every live context of all threads; maintained only if the library was
+// built with BOOST_CONTEXT_USE_REGISTRY (registry=on), empty otherwise
+//
+// the frames of suspended contexts are taken from the saved frame-pointer
+// chain (x86_64 System V only, requires -fno-omit-frame-pointer)
+BOOST_CONTEXT_DECL std::vector< context_backtrace > context_backtraces( std::size_t max_frames = 64);
+
+// writes the symbolized backtraces of context_backtraces() to `os`;
+// not async-signal-safe
+BOOST_CONTEXT_DECL void write_backtraces( std::ostream & os, std::size_t max_frames = 64);
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_REGISTRY_H
@@ -0,0 +1,545 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_SCHEDULER_H
+#define BOOST_CONTEXT_SCHEDULER_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <atomic>
+# include <chrono>
+# include <cstddef>
+# include <cstdint>
+# include <exception>
+# include <memory>
+# include <new>
+# include <tuple>
+# include <utility>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# include <boost/context/detail/futex.hpp>
+# include <boost/context/detail/invoke.hpp>
+# include <boost/context/detail/spinlock.hpp>
+# include <boost/context/execution_context.hpp>
+# include <boost/context/fixedsize_stack.hpp>
+# include <boost/context/segmented_stack.hpp>
+# include <boost/context/stack_context.hpp>
+# include <boost/context/timer_wheel.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+class scheduler;
+class io_driver;
+
+template< typename StackAlloc >
+class basic_nursery;
+
+namespace detail {
+
+struct task_record;
+struct waiter;
+class wait_queue;
+class watchdog;
+
+// armed while a context waits with a deadline
+struct task_timer : public timer_wheel::timer {
+    task_record     *   task;
+    // invoked on expiry; the context becomes ready only if `fn` returns true
+    bool           (*   fn)( void *);
+    void            *   vp;
+    bool                expired;
+
+    task_timer( task_record * task_, bool (* fn_)( void *), void * vp_) noexcept :
+        timer(),
+        task( task_),
+        fn( fn_),
+        vp( vp_),
+        expired( false) {
+    }
+};
+
+}
+
+// scheduling class of a context managed by a scheduler
+struct task_attributes {
+    // strict priority, 0 (default) ... scheduler::max_priority; ready
+    // contexts of higher priority are dispatched first
+    unsigned int                            priority;
+    // ready contexts with a deadline are dispatched before all priorities,
+    // earliest deadline first; max() (default) means no deadline
+    std::chrono::steady_clock::time_point   deadline;
+
+    task_attributes() noexcept :
+        priority( 0),
+        deadline( ( std::chrono::steady_clock::time_point::max)() ) {
+    }
+
+    explicit task_attributes( unsigned int priority_,
+                              std::chrono::steady_clock::time_point deadline_ =
+                                ( std::chrono::steady_clock::time_point::max)() ) noexcept :
+        priority( priority_),
+        deadline( deadline_) {
+    }
+};
+
+// refers to a context spawned by a scheduler; valid until the context has
+// terminated, a default constructed handle refers to no context
+class task_handle {
+private:
+    friend class scheduler;
+
+    detail::task_record *   task_;
+
+    explicit task_handle( detail::task_record * task) noexcept :
+        task_( task) {
+    }
+
+public:
+    task_handle() noexcept :
+        task_( nullptr) {
+    }
+
+    explicit operator bool() const noexcept {
+        return nullptr != task_;
+    }
+
+    bool operator!() const noexcept {
+        return nullptr == task_;
+    }
+
+    bool operator==( task_handle const& other) const noexcept {
+        return task_ == other.task_;
+    }
+
+    bool operator!=( task_handle const& other) const noexcept {
+        return task_ != other.task_;
+    }
+};
+
+class BOOST_CONTEXT_DECL scheduler {
+public:
+    typedef std::chrono::steady_clock   clock_type;
+
+    static constexpr unsigned int max_priority = 7;
+
+    // source of completions (I/O, timers of the OS, ...)
+    // consulted by the dispatcher once per tick
+    class poller {
+    public:
+        virtual ~poller() {}
+
+        // submit requests issued during the current tick and make
+        // the contexts of completed requests ready; never blocks
+        virtual void poll() = 0;
+
+        // block until at least one request completes or `deadline` is reached
+        virtual void wait( clock_type::time_point deadline) = 0;
+
+        // true if requests are in flight
+        virtual bool busy() const noexcept = 0;
+
+        // interrupt wait(); called from other threads
+        virtual void notify() noexcept = 0;
+    };
+
+private:
+    friend struct detail::task_record;
+    friend struct detail::waiter;
+    friend class detail::wait_queue;
+    friend class detail::watchdog;
+    friend class io_driver;
+    template< typename StackAlloc >
+    friend class basic_nursery;
+
+    thread_local static scheduler   *   current_;
+
+    execution_context       dispatcher_;
+    detail::task_record *   running_;
+    // ready contexts without deadline, one FIFO per priority
+    detail::task_record *   ready_heads_[max_priority + 1];
+    detail::task_record **  ready_tails_[max_priority + 1];
+    // bit `p` is set while the FIFO of priority `p` is not empty
+    unsigned int            ready_mask_;
+    // ready contexts with deadline, leftist heap ordered by deadline
+    detail::task_record *   ready_edf_;
+    std::size_t             ready_count_;
+    // orders contexts with equal deadlines by their arrival
+    std::uint64_t           ready_seq_;
+    // dispatches in a row that passed over a ready context of lower
+    // priority
+    std::size_t             bypassed_;
+    std::size_t             starvation_limit_;
+    // dispatches left in the current tick; a suspending context resumes
+    // the next ready context directly while it is not zero
+    std::size_t             budget_;
+    // terminated context, destroyed by the next context resumed (its stack
+    // is released once it switched away)
+    detail::task_record *   zombie_;
+    // contexts spawned and not yet destroyed
+    detail::task_record *   tasks_;
+    std::size_t             live_;
+    poller              *   poller_;
+    timer_wheel             wheel_;
+    clock_type::time_point  origin_;
+    clock_type::duration    resolution_;
+    // contexts suspended on a synchronization primitive,
+    // these might be woken by other threads
+    std::size_t             blocked_;
+    // contexts made ready by other threads
+    detail::spinlock        remote_splk_;
+    detail::task_record *   remote_head_;
+    detail::task_record **  remote_tail_;
+    bool                    idle_;
+    detail::futex_type      wake_;
+    // value of `wake_` at the last drain_remote_()
+    std::int32_t            drained_;
+    // cooperative preemption, see time_slice()
+    clock_type::duration    slice_;
+    // incremented before and after each resumption, odd while a context
+    // runs; observed by the watchdog
+    std::atomic< std::uint64_t >    resumptions_;
+    // set by the watchdog if a context runs longer than `slice_`
+    std::atomic< bool >     preempt_;
+
+    void resume_( detail::task_record *) noexcept;
+
+    void enlist_( detail::task_record *) noexcept;
+
+    void destroy_( detail::task_record *) noexcept;
+
+    void unwind_( detail::task_record *) noexcept;
+
+    void unwind_all_() noexcept;
+
+    void push_ready_( detail::task_record *) noexcept;
+
+    detail::task_record * pop_ready_() noexcept;
+
+    detail::task_record * next_ready_() noexcept;
+
+    void transfer_( detail::task_record *) noexcept;
+
+    void reap_() noexcept;
+
+    void ready_( detail::task_record *) noexcept;
+
+    void ready_remote_( detail::task_record *) noexcept;
+
+    void switch_to_( detail::task_record *);
+
+    // switch_to_() without cancellation check
+    void transfer_to_( detail::task_record *) noexcept;
+
+    void expire_( detail::task_timer *) noexcept;
+
+    // ends a wait with deadline of `t` as timed out
+    void interrupt_( detail::task_record *) noexcept;
+
+    // suspension without cancellation check, for callers that have to
+    // complete their bookkeeping after the resumption
+    void yield_() noexcept;
+
+    void suspend_() noexcept;
+
+    bool suspend_until_( clock_type::time_point deadline,
+                         bool (* fn)( void *), void * vp) noexcept;
+
+    void expire_timers_() noexcept;
+
+    void drain_remote_() noexcept;
+
+    void idle_wait_( clock_type::time_point) noexcept;
+
+    std::uint64_t to_tick_( clock_type::time_point) const noexcept;
+
+    clock_type::time_point from_tick_( std::uint64_t) const noexcept;
+
+public:
+    static scheduler * current() noexcept;
+
+    // deadlines are rounded up to multiples of `resolution`
+    explicit scheduler( clock_type::duration resolution = std::chrono::milliseconds( 1) );
+
+    // contexts not terminated (run() not called or returned while the
+    // contexts wait for each other) are unwound
+    ~scheduler();
+
+    scheduler( scheduler const&) = delete;
+    scheduler & operator=( scheduler const&) = delete;
+
+# if defined(BOOST_USE_SEGMENTED_STACKS)
+    template< typename Fn, typename ... Args >
+    void spawn( Fn && fn, Args && ... args) {
+        spawn( task_attributes(), std::allocator_arg, segmented_stack(),
+               std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+
+    template< typename Fn, typename ... Args >
+    void spawn( task_attributes attrs, Fn && fn, Args && ... args) {
+        spawn( attrs, std::allocator_arg, segmented_stack(),
+               std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+# else
+    template< typename Fn, typename ... Args >
+    void spawn( Fn && fn, Args && ... args) {
+        spawn( task_attributes(), std::allocator_arg, fixedsize_stack(),
+               std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+
+    template< typename Fn, typename ... Args >
+    void spawn( task_attributes attrs, Fn && fn, Args && ... args) {
+        spawn( attrs, std::allocator_arg, fixedsize_stack(),
+               std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+# endif
+
+    template< typename StackAlloc, typename Fn, typename ... Args >
+    void spawn( std::allocator_arg_t, StackAlloc salloc, Fn && fn, Args && ... args) {
+        spawn( task_attributes(), std::allocator_arg, salloc,
+               std::forward< Fn >( fn), std::forward< Args >( args) ... );
+    }
+
+    // the attributes are taken by value (as std::allocator_arg_t), this
+    // overload is preferred to the ones above
+    template< typename StackAlloc, typename Fn, typename ... Args >
+    void spawn( task_attributes attrs, std::allocator_arg_t, StackAlloc salloc, Fn && fn, Args && ... args);
+
+    // dispatch ready contexts until all spawned contexts have terminated
+    // or none of the remaining contexts can make progress
+    // (contexts blocked on a synchronization primitive are expected to be
+    // woken by other threads)
+    void run();
+
+    // the suspension points below (yield, suspend, switch_to, yield_to,
+    // suspend_until, sleep_until, sleep_for, maybe_yield) throw
+    // forced_unwind if the running context has been cancelled, see
+    // execution_context::cancellation()
+
+    // re-schedule the running context behind all other ready contexts of
+    // its scheduling class
+    void yield();
+
+    // suspend the running context and resume `t` directly (symmetric
+    // transfer, one context switch instead of two via the dispatcher); `t`
+    // must be suspended, not ready and not blocked in a synchronization
+    // primitive; a pending timeout of `t` is cancelled
+    void switch_to( task_handle t) {
+        switch_to_( t.task_);
+    }
+
+    // as switch_to(), the running context is appended to the ready queue
+    void yield_to( task_handle t);
+
+    // scheduling class of the running context, applied the next time it
+    // becomes ready
+    void attributes( task_attributes const& attrs) noexcept;
+
+    task_attributes attributes() const noexcept;
+
+    // after `n` dispatches in a row passing over a ready context of lower
+    // priority, the lowest ready priority is served once (starvation
+    // protection); zero disables it, the default is 16
+    void starvation_limit( std::size_t n) noexcept {
+        starvation_limit_ = n;
+    }
+
+    // suspend the running context; it is resumed after ready() was
+    // called for it
+    void suspend();
+
+    // requests the cancellation of `t` (the token attached to its context);
+    // if `t` sleeps or waits with a deadline, the wait ends as timed out
+    // immediately, other waits are not interrupted; a running context
+    // observes it at its next suspension point
+    void cancel( task_handle t);
+
+    // opt-in cooperative preemption: a watchdog thread requests a yield
+    // once a context runs longer than `slice` (zero, the default, disables
+    // it); the request is honoured by maybe_yield(), a context is never
+    // interrupted
+    void time_slice( clock_type::duration slice);
+
+    clock_type::duration time_slice() const noexcept {
+        return slice_;
+    }
+
+    // yields if the running context exceeded its time slice; called by the
+    // synchronization primitives even if they do not suspend
+    bool maybe_yield() {
+        if ( ! preempt_.load( std::memory_order_relaxed) || nullptr == running_) {
+            return false;
+        }
+        yield();
+        return true;
+    }
+
+    // suspend the running context until ready() was called for it or
+    // `deadline` was reached; returns false on timeout
+    // `fn( vp)` is invoked on timeout; if it returns false the context
+    // stays suspended (the wake-up is already under way)
+    bool suspend_until( clock_type::time_point deadline,
+                        bool (* fn)( void *) = nullptr, void * vp = nullptr);
+
+    void sleep_until( clock_type::time_point tp);
+
+    template< typename Rep, typename Period >
+    void sleep_for( std::chrono::duration< Rep, Period > const& d) {
+        sleep_until( clock_type::now() + std::chrono::duration_cast< clock_type::duration >( d) );
+    }
+
+    // append `t` to the ready queue, cancels a pending timeout of `t`
+    void ready( task_handle t) noexcept {
+        ready_( t.task_);
+    }
+
+    // thread-safe variant of ready(); wakes the dispatcher if it is idle
+    void ready_remote( task_handle t) noexcept {
+        ready_remote_( t.task_);
+    }
+
+    // terminate the running context; never returns
+    BOOST_NORETURN void exit() noexcept;
+
+    task_handle running() const noexcept {
+        return task_handle( running_);
+    }
+
+    std::size_t live() const noexcept {
+        return live_;
+    }
+
+    void attach( poller * p) noexcept {
+        BOOST_ASSERT( nullptr == poller_);
+        poller_ = p;
+    }
+
+    void detach( poller * p) noexcept {
+        BOOST_ASSERT( p == poller_);
+        (void)p;
+        poller_ = nullptr;
+    }
+};
+
+// maybe_yield() of the scheduler running on the calling thread; cheap
+// enough for the inner loops of long computations
+inline
+bool maybe_yield() {
+    scheduler * s = scheduler::current();
+    return nullptr != s && s->maybe_yield();
+}
+
+namespace detail {
+
+// bookkeeping of a context managed by a scheduler;
+// placed on top of the context's stack
+struct task_record {
+    scheduler           *   sched;
+    // link of the FIFO of ready contexts
+    task_record         *   nxt;
+    task_timer          *   tmo;
+    bool                    terminated;
+    // linked into the ready queue (FIFO or heap)
+    bool                    ready;
+    task_attributes         attrs;
+    // node of the heap of ready contexts with deadline
+    task_record         *   left;
+    task_record         *   right;
+    std::size_t             rank;
+    std::uint64_t           seq;
+    // links of the list of contexts alive in the scheduler
+    task_record         *   live_prev;
+    task_record         *   live_nxt;
+    // constructed last, the context-function refers to the members above
+    execution_context       ctx;
+
+    template< typename StackAlloc, typename Fn, typename Tpl >
+    task_record( scheduler * sched_, task_attributes const& attrs_, preallocated palloc, StackAlloc salloc,
+                 Fn && fn, Tpl && tpl) :
+        sched( sched_),
+        nxt( nullptr),
+        tmo( nullptr),
+        terminated( false),
+        ready( false),
+        attrs( attrs_),
+        left( nullptr),
+        right( nullptr),
+        rank( 0),
+        seq( 0),
+        live_prev( nullptr),
+        live_nxt( nullptr),
+        ctx( std::allocator_arg, palloc, salloc,
+             [this,fn=std::forward< Fn >( fn),tpl=std::forward< Tpl >( tpl)] (void *) mutable {
+                // resumed for the first time, possibly by a terminated context
+                sched->reap_();
+                try {
+                    do_invoke( fn, std::move( tpl) );
+                } catch ( forced_unwind const&) {
+                    // cancelled, the stack has been unwound
+                } catch (...) {
+                    // the resumer is an unrelated context (another context
+                    // or the dispatcher), the exception can not be rethrown
+                    std::terminate();
+                }
+                // the stack is released by the dispatcher
+                sched->exit();
+             }) {
+    }
+};
+
+}
+
+template< typename StackAlloc, typename Fn, typename ... Args >
+void
+scheduler::spawn( task_attributes attrs, std::allocator_arg_t, StackAlloc salloc, Fn && fn, Args && ... args) {
+    BOOST_ASSERT( attrs.priority <= max_priority);
+    stack_context sctx( salloc.allocate() );
+    // reserve space for task record on top of the stack
+#if defined(BOOST_NO_CXX14_CONSTEXPR) || defined(BOOST_NO_CXX11_STD_ALIGN)
+    std::size_t size = sctx.size - sizeof( detail::task_record);
+    void * sp = static_cast< char * >( sctx.sp) - sizeof( detail::task_record);
+#else
+    constexpr std::size_t func_alignment = 64; // alignof( detail::task_record);
+    constexpr std::size_t func_size = sizeof( detail::task_record);
+    // reserve space on stack
+    void * sp = static_cast< char * >( sctx.sp) - func_size - func_alignment;
+    // align sp pointer
+    std::size_t space = func_size + func_alignment;
+    sp = std::align( func_alignment, func_size, sp, space);
+    BOOST_ASSERT( nullptr != sp);
+    // calculate remaining size
+    std::size_t size = sctx.size - ( static_cast< char * >( sctx.sp) - static_cast< char * >( sp) );
+#endif
+    detail::task_record * t = nullptr;
+    try {
+        // placement new for task record on top of the stack
+        t = new ( sp) detail::task_record(
+                this, attrs, preallocated( sp, size, sctx), salloc,
+                std::forward< Fn >( fn), std::make_tuple( std::forward< Args >( args) ... ) );
+    } catch (...) {
+        salloc.deallocate( sctx);
+        throw;
+    }
+    enlist_( t);
+    ready_( t);
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_SCHEDULER_H
@@ -0,0 +1,73 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_SEMAPHORE_H
+#define BOOST_CONTEXT_SEMAPHORE_H
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include <chrono>
+# include <cstddef>
+
+# include <boost/config.hpp>
+
+# include <boost/context/detail/spinlock.hpp>
+# include <boost/context/detail/wait_queue.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+// counting semaphore; release() hands permits directly to the
+// waiting contexts in FIFO order
+class BOOST_CONTEXT_DECL semaphore {
+private:
+    detail::spinlock        splk_;
+    std::ptrdiff_t          count_;
+    detail::wait_queue      waiters_;
+
+    bool acquire_( std::chrono::steady_clock::time_point deadline) noexcept;
+
+public:
+    explicit semaphore( std::ptrdiff_t count = 0) noexcept;
+
+    ~semaphore();
+
+    semaphore( semaphore const&) = delete;
+    semaphore & operator=( semaphore const&) = delete;
+
+    void acquire() noexcept {
+        acquire_( std::chrono::steady_clock::time_point::max() );
+    }
+
+    bool try_acquire() noexcept;
+
+    template< typename Clock, typename Duration >
+    bool try_acquire_until( std::chrono::time_point< Clock, Duration > const& tp) noexcept {
+        return acquire_( detail::to_steady( tp) );
+    }
+
+    template< typename Rep, typename Period >
+    bool try_acquire_for( std::chrono::duration< Rep, Period > const& d) noexcept {
+        return try_acquire_until( std::chrono::steady_clock::now() + d);
+    }
+
+    void release( std::ptrdiff_t update = 1) noexcept;
+};
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
+
+#endif // BOOST_CONTEXT_SEMAPHORE_H
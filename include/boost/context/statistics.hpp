@@ -0,0 +1,62 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_STATISTICS_H
+#define BOOST_CONTEXT_STATISTICS_H
+
+#include <cstdint>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+// maintained only if the library was built with
+// BOOST_CONTEXT_USE_STATISTICS (statistics=on), zero otherwise
+struct context_statistics {
+    // context switches (execution_context::operator())
+    std::int64_t    switches;
+    std::int64_t    creations;
+    std::int64_t    destructions;
+    // creations - destructions; a context destroyed by another thread than
+    // the creating one is counted by the destroying thread, the value of a
+    // single thread might be negative
+    std::int64_t    live;
+    // bytes of stack currently allocated by each stack allocator
+    std::int64_t    fixedsize_stack_bytes;
+    std::int64_t    protected_fixedsize_stack_bytes;
+    std::int64_t    segmented_stack_bytes;
+
+    context_statistics & operator+=( context_statistics const& other) noexcept {
+        switches += other.switches;
+        creations += other.creations;
+        destructions += other.destructions;
+        live += other.live;
+        fixedsize_stack_bytes += other.fixedsize_stack_bytes;
+        protected_fixedsize_stack_bytes += other.protected_fixedsize_stack_bytes;
+        segmented_stack_bytes += other.segmented_stack_bytes;
+        return * this;
+    }
+};
+
+// counters of the calling thread
+BOOST_CONTEXT_DECL context_statistics thread_statistics() noexcept;
+
+// sum of the counters of all threads, including terminated threads
+BOOST_CONTEXT_DECL context_statistics aggregate_statistics() noexcept;
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_STATISTICS_H
@@ -0,0 +1,312 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_TIMER_WHEEL_H
+#define BOOST_CONTEXT_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <boost/assert.hpp>
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+inline
+unsigned int msb64( std::uint64_t v) noexcept {
+    BOOST_ASSERT( 0 != v);
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll( v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanReverse64( & idx, v);
+    return idx;
+#else
+    unsigned int idx = 0;
+    while ( v >>= 1) {
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+inline
+unsigned int lsb64( std::uint64_t v) noexcept {
+    BOOST_ASSERT( 0 != v);
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll( v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64( & idx, v);
+    return idx;
+#else
+    unsigned int idx = 0;
+    while ( 0 == ( v & 1) ) {
+        v >>= 1;
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+}
+
+// hashed hierarchical timing wheel
+// level L holds timers whose expiry differs from the current tick first in
+// digit L (6 bits per digit); a slot of level L > 0 is cascaded to the lower
+// levels when the current tick enters it, slots of level 0 expire
+class timer_wheel {
+public:
+    // intrusive hook, embedded in the object waiting for expiry
+    struct timer {
+        timer           *   prev;
+        timer           *   next;
+        std::uint64_t       expiry;
+
+        timer() noexcept :
+            prev( nullptr),
+            next( nullptr),
+            expiry( 0) {
+        }
+
+        bool linked() const noexcept {
+            return nullptr != prev;
+        }
+    };
+
+    BOOST_STATIC_CONSTEXPR unsigned int bits = 6;
+    BOOST_STATIC_CONSTEXPR unsigned int slots = 1u << bits;
+    BOOST_STATIC_CONSTEXPR unsigned int levels = 6;
+
+private:
+    timer               wheel_[levels][slots];
+    std::uint64_t       occupied_[levels];
+    // expiry beyond the range of the top level
+    timer               overflow_;
+    timer               expired_;
+    std::uint64_t       now_;
+    std::size_t         size_;
+
+    static void init_( timer * l) noexcept {
+        l->prev = l->next = l;
+    }
+
+    static bool empty_( timer const* l) noexcept {
+        return l->next == l;
+    }
+
+    static void push_back_( timer * l, timer * t) noexcept {
+        t->next = l;
+        t->prev = l->prev;
+        l->prev->next = t;
+        l->prev = t;
+    }
+
+    static void unlink_( timer * t) noexcept {
+        t->prev->next = t->next;
+        t->next->prev = t->prev;
+        t->prev = t->next = nullptr;
+    }
+
+    // move all timers of `from` to the end of `to`
+    static void splice_( timer * to, timer * from) noexcept {
+        if ( empty_( from) ) {
+            return;
+        }
+        from->next->prev = to->prev;
+        to->prev->next = from->next;
+        from->prev->next = to;
+        to->prev = from->prev;
+        init_( from);
+    }
+
+    void place_( timer * t) noexcept {
+        if ( t->expiry <= now_) {
+            push_back_( & expired_, t);
+            return;
+        }
+        const unsigned int level = detail::msb64( t->expiry ^ now_) / bits;
+        if ( levels <= level) {
+            push_back_( & overflow_, t);
+            return;
+        }
+        const unsigned int slot = static_cast< unsigned int >( t->expiry >> ( level * bits) ) & ( slots - 1);
+        push_back_( & wheel_[level][slot], t);
+        occupied_[level] |= std::uint64_t( 1) << slot;
+    }
+
+    void cascade_( timer * l) noexcept {
+        timer tmp;
+        init_( & tmp);
+        splice_( & tmp, l);
+        while ( ! empty_( & tmp) ) {
+            timer * t = tmp.next;
+            unlink_( t);
+            place_( t);
+        }
+    }
+
+    // first tick at which a slot has to be expired or cascaded
+    std::uint64_t next_event_() const noexcept {
+        for ( unsigned int level = 0; level < levels; ++level) {
+            const unsigned int shift = level * bits;
+            const unsigned int digit = static_cast< unsigned int >( now_ >> shift) & ( slots - 1);
+            // slots before and at the current digit are empty
+            const std::uint64_t pending = slots - 1 == digit
+                ? 0
+                : occupied_[level] & ( ~std::uint64_t( 0) << ( digit + 1) );
+            if ( 0 != pending) {
+                // events of lower levels occur before events of higher levels
+                const std::uint64_t base = ( now_ >> ( shift + bits) ) << ( shift + bits);
+                return base + ( std::uint64_t( detail::lsb64( pending) ) << shift);
+            }
+        }
+        if ( ! empty_( & overflow_) ) {
+            return ( ( now_ >> ( levels * bits) ) + 1) << ( levels * bits);
+        }
+        return ( std::numeric_limits< std::uint64_t >::max)();
+    }
+
+    // `now_` entered a new tick
+    void process_() noexcept {
+        if ( 0 == ( now_ & ( ( std::uint64_t( 1) << ( levels * bits) ) - 1) ) ) {
+            cascade_( & overflow_);
+        }
+        // higher levels first, their timers might be cascaded
+        // into the slots of the lower levels entered by this tick
+        for ( unsigned int level = levels - 1; 0 < level; --level) {
+            const unsigned int shift = level * bits;
+            if ( 0 != ( now_ & ( ( std::uint64_t( 1) << shift) - 1) ) ) {
+                continue;
+            }
+            const unsigned int slot = static_cast< unsigned int >( now_ >> shift) & ( slots - 1);
+            if ( 0 != ( occupied_[level] & ( std::uint64_t( 1) << slot) ) ) {
+                occupied_[level] &= ~( std::uint64_t( 1) << slot);
+                cascade_( & wheel_[level][slot]);
+            }
+        }
+        const unsigned int slot = static_cast< unsigned int >( now_) & ( slots - 1);
+        if ( 0 != ( occupied_[0] & ( std::uint64_t( 1) << slot) ) ) {
+            occupied_[0] &= ~( std::uint64_t( 1) << slot);
+            splice_( & expired_, & wheel_[0][slot]);
+        }
+    }
+
+public:
+    explicit timer_wheel( std::uint64_t now = 0) noexcept :
+        now_( now),
+        size_( 0) {
+        for ( unsigned int level = 0; level < levels; ++level) {
+            for ( unsigned int slot = 0; slot < slots; ++slot) {
+                init_( & wheel_[level][slot]);
+            }
+            occupied_[level] = 0;
+        }
+        init_( & overflow_);
+        init_( & expired_);
+    }
+
+    timer_wheel( timer_wheel const&) = delete;
+    timer_wheel & operator=( timer_wheel const&) = delete;
+
+    std::uint64_t now() const noexcept {
+        return now_;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return 0 == size_;
+    }
+
+    // O(1); a timer expiring at or before now() is expired immediately
+    void insert( timer * t, std::uint64_t expiry) noexcept {
+        BOOST_ASSERT( nullptr != t);
+        BOOST_ASSERT( ! t->linked() );
+        t->expiry = expiry;
+        place_( t);
+        ++size_;
+    }
+
+    // O(1); no-op if `t` is not linked (e.g. already popped)
+    void cancel( timer * t) noexcept {
+        BOOST_ASSERT( nullptr != t);
+        if ( ! t->linked() ) {
+            return;
+        }
+        timer * prev = t->prev;
+        unlink_( t);
+        --size_;
+        if ( empty_( prev) ) {
+            // `prev` is the sentinel of the slot; update the bitmap
+            // if the slot belongs to the wheel
+            // overflow_/expired_ are not elements of `wheel_`, pointer
+            // arithmetic on them is undefined; compare addresses instead
+            // (wraps around if `prev` is located before `wheel_`)
+            const std::uintptr_t offset = reinterpret_cast< std::uintptr_t >( prev) -
+                                          reinterpret_cast< std::uintptr_t >( & wheel_);
+            if ( sizeof( wheel_) > offset) {
+                const std::size_t idx = offset / sizeof( timer);
+                occupied_[idx / slots] &= ~( std::uint64_t( 1) << ( idx % slots) );
+            }
+        }
+    }
+
+    // advance the wheel to tick `now`; timers expiring in the passed ticks
+    // are collected and handed out by pop_expired()
+    void advance( std::uint64_t now) noexcept {
+        while ( now_ < now) {
+            const std::uint64_t ev = next_event_();
+            if ( ev > now) {
+                // no slot to expire or cascade, skip the empty ticks
+                now_ = now;
+                break;
+            }
+            now_ = ev;
+            process_();
+        }
+    }
+
+    timer * pop_expired() noexcept {
+        if ( empty_( & expired_) ) {
+            return nullptr;
+        }
+        timer * t = expired_.next;
+        unlink_( t);
+        --size_;
+        return t;
+    }
+
+    // tick of the next expiry (lower bound), max() if no timer is pending
+    std::uint64_t next_expiry() const noexcept {
+        if ( ! empty_( & expired_) ) {
+            return now_;
+        }
+        return next_event_();
+    }
+};
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_TIMER_WHEEL_H
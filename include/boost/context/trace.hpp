@@ -0,0 +1,42 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef BOOST_CONTEXT_TRACE_H
+#define BOOST_CONTEXT_TRACE_H
+
+#include <iosfwd>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+// the switches are recorded only if the library was built with
+// BOOST_CONTEXT_USE_TRACE (trace=on); recording is enabled by default
+BOOST_CONTEXT_DECL void trace_enable( bool enable) noexcept;
+
+BOOST_CONTEXT_DECL bool trace_enabled() noexcept;
+
+// discards the recorded events of all threads
+BOOST_CONTEXT_DECL void trace_clear() noexcept;
+
+// writes the recorded events in the Chrome trace-event format
+// (chrome://tracing, Perfetto); each thread is a track, each interval
+// between two switches a slice named after the resumed context
+BOOST_CONTEXT_DECL void write_trace( std::ostream & os);
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
+
+#endif // BOOST_CONTEXT_TRACE_H
@@ -18,6 +18,7 @@ extern "C" {
 #include <boost/config.hpp>
 
 #include <boost/context/detail/config.hpp>
+#include <boost/context/detail/statistics.hpp>
 #include <boost/context/stack_context.hpp>
 #include <boost/context/stack_traits.hpp>
 
@@ -73,6 +74,7 @@ public:
         stack_context sctx;
         sctx.size = size__;
         sctx.sp = static_cast< char * >( vp) + sctx.size;
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_protected_fixedsize], static_cast< std::int64_t >( sctx.size) );
         return sctx;
     }
 
@@ -83,6 +85,7 @@ public:
         BOOST_ASSERT( traits_type::is_unbounded() || ( traits_type::maximum_size() >= sctx.size) );
 #endif
 
+        BOOST_CONTEXT_COUNT( stack_bytes[detail::stack_protected_fixedsize], -static_cast< std::int64_t >( sctx.size) );
         void * vp = static_cast< char * >( sctx.sp) - sctx.size;
         ::VirtualFree( vp, 0, MEM_RELEASE);
     }
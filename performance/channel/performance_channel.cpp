@@ -0,0 +1,162 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../stats.hpp"
+
+// messages per sample
+boost::uint64_t messages = 100000;
+// samples
+boost::uint64_t runs = 10;
+std::size_t capacity = 64;
+unsigned int fan = 4;
+
+// producers push `messages` values in total, consumers pop until the
+// channel is closed; with `cross` the consumers run on a second thread
+template< typename Channel >
+duration_type measure_once( unsigned int producers, unsigned int consumers, bool cross) {
+    Channel ch( capacity);
+    boost::uint64_t sum = 0;
+    auto consume = [&ch,&sum,consumers]( boost::context::scheduler & s){
+        for ( unsigned int i = 0; i < consumers; ++i) {
+            s.spawn( [&ch,&sum](){
+                        boost::uint64_t v = 0, local = 0;
+                        while ( boost::context::channel_op_status::success == ch.pop( v) ) {
+                            local += v;
+                        }
+                        sum += local;
+                     });
+        }
+    };
+    time_point_type start( clock_type::now() );
+    std::thread t;
+    boost::context::scheduler s;
+    if ( cross) {
+        t = std::thread( [&consume](){
+                    boost::context::scheduler s;
+                    consume( s);
+                    s.run();
+                 });
+    } else {
+        consume( s);
+    }
+    unsigned int running = producers;
+    for ( unsigned int i = 0; i < producers; ++i) {
+        s.spawn( [&ch,&running,producers,i](){
+                    for ( boost::uint64_t v = i; v < messages; v += producers) {
+                        ch.push( v);
+                    }
+                    if ( 0 == --running) {
+                        ch.close();
+                    }
+                 });
+    }
+    s.run();
+    if ( cross) {
+        t.join();
+    }
+    duration_type total = clock_type::now() - start;
+    if ( sum != messages * ( messages - 1) / 2) {
+        throw std::logic_error("wrong checksum");
+    }
+    return total;
+}
+
+// ns per message of each sample
+template< typename Channel >
+std::vector< double > measure( unsigned int producers, unsigned int consumers, bool cross) {
+    std::vector< double > samples;
+    samples.reserve( runs);
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        samples.push_back(
+            static_cast< double >( measure_once< Channel >( producers, consumers, cross).count() ) / messages);
+    }
+    return samples;
+}
+
+void run( report & r, std::string name, unsigned int producers, unsigned int consumers, bool cross) {
+    if ( cross) {
+        name += " (cross-thread)";
+    }
+    std::map< std::string, double > extra;
+    extra["producers"] = producers;
+    extra["consumers"] = consumers;
+    extra["capacity"] = static_cast< double >( capacity);
+    extra["cross"] = cross ? 1. : 0.;
+    if ( ! cross) {
+        r.add( "local_channel " + name, "ns",
+               measure< boost::context::local_channel< boost::uint64_t > >( producers, consumers, false), extra);
+    }
+    r.add( "channel " + name, "ns",
+           measure< boost::context::channel< boost::uint64_t > >( producers, consumers, cross), extra);
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+        bool cross = false;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("messages,m", boost::program_options::value< boost::uint64_t >( & messages), "messages per sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("capacity,c", boost::program_options::value< std::size_t >( & capacity), "capacity of the channel")
+            ("fan,f", boost::program_options::value< unsigned int >( & fan), "producers/consumers of MPSC/MPMC")
+            ("cross,x", boost::program_options::bool_switch( & cross), "consumers run on a second thread")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        if ( 0 == messages || 0 == runs) {
+            throw std::invalid_argument("messages and runs must not be zero");
+        }
+        if ( ! cross) {
+            bind_to_processor( 0);
+        }
+
+        report r("channel", json, csv);
+        run( r, "SPSC", 1, 1, cross);
+        run( r, "MPSC", fan, 1, cross);
+        run( r, "MPMC", fan, fan, cross);
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
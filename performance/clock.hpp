@@ -8,6 +8,7 @@
 #define CLOCK_H
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <numeric>
 #include <vector>
@@ -20,26 +21,29 @@ typedef boost::chrono::high_resolution_clock    clock_type;
 typedef clock_type::duration                    duration_type;
 typedef clock_type::time_point                  time_point_type;
 
-struct clock_overhead
+// minimum of back-to-back measurements; the average would include
+// interrupts and migrations
+inline
+duration_type overhead_clock()
 {
-    boost::uint64_t operator()()
-    {
+    duration_type overhead = ( duration_type::max)();
+    for ( std::size_t i = 0; i < 1000; ++i) {
         time_point_type start( clock_type::now() );
-        return ( clock_type::now() - start).count();
+        overhead = ( std::min)( overhead, duration_type( clock_type::now() - start) );
     }
-};
+    return overhead;
+}
 
+// batch mode: operations per sample such that the overhead of the
+// measurement stays below `fraction` of the measured interval
 inline
-duration_type overhead_clock()
+boost::uint64_t batch_size( double overhead, double per_op, double fraction = 0.01)
 {
-    std::size_t iterations( 10);
-    std::vector< boost::uint64_t >  overhead( iterations, 0);
-    for ( std::size_t i = 0; i < iterations; ++i)
-        std::generate(
-            overhead.begin(), overhead.end(),
-            clock_overhead() );
-    BOOST_ASSERT( overhead.begin() != overhead.end() );
-    return duration_type( std::accumulate( overhead.begin(), overhead.end(), 0) / iterations);
+    if ( 0. >= per_op) {
+        return 1;
+    }
+    return ( std::max)( boost::uint64_t( 1),
+                        static_cast< boost::uint64_t >( std::ceil( overhead / ( fraction * per_op) ) ) );
 }
 
 #endif // CLOCK_H
@@ -0,0 +1,243 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// runs the benchmarks of performance/, stores their results as baselines
+// and compares later runs against the baseline:
+//
+//   performance_compare --record  ../execution_context/performance_execution_context ...
+//   performance_compare           ../execution_context/performance_execution_context ...
+//
+// the baselines are stored in <baseline-dir>/<cpu model>-<build flags>/;
+// arguments ending in `.json` are taken as results of a previous run
+// (written with `--json`) instead of being executed
+
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "../stats.hpp"
+
+// exit code if a regression was found
+const int exit_regression = 2;
+
+struct result
+{
+    std::string             name;
+    std::string             unit;
+    std::vector< double >   values;
+};
+
+struct benchmark
+{
+    std::string                 name;
+    std::vector< result >       results;
+};
+
+std::string sanitize( std::string const& s) {
+    std::string r;
+    for ( char c : s) {
+        r += std::isalnum( static_cast< unsigned char >( c) ) || '.' == c ? c : '_';
+    }
+    return r;
+}
+
+std::string cpu_model() {
+#if defined(__linux__)
+    std::ifstream is("/proc/cpuinfo");
+    std::string line;
+    while ( std::getline( is, line) ) {
+        if ( 0 == line.compare( 0, 10, "model name") ) {
+            std::string::size_type pos = line.find( ':');
+            if ( std::string::npos != pos) {
+                std::string::size_type first = line.find_first_not_of( " \t", pos + 1);
+                return std::string::npos != first ? line.substr( first) : std::string("unknown");
+            }
+        }
+    }
+#endif
+    return "unknown";
+}
+
+// the compiler and the build variant of this driver; the benchmarks are
+// built with the same toolset and variant
+std::string build_flags() {
+    std::string flags( BOOST_COMPILER);
+#if defined(NDEBUG) || defined(BOOST_DISABLE_ASSERTS)
+    flags += " release";
+#else
+    flags += " debug";
+#endif
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+    flags += " segmented";
+#endif
+    return flags;
+}
+
+benchmark load( std::string const& path) {
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json( path, pt);
+    benchmark b;
+    b.name = pt.get< std::string >("benchmark");
+    for ( auto const& r : pt.get_child("results") ) {
+        result x;
+        x.name = r.second.get< std::string >("name");
+        x.unit = r.second.get< std::string >("unit");
+        for ( auto const& v : r.second.get_child("values") ) {
+            x.values.push_back( v.second.get_value< double >() );
+        }
+        b.results.push_back( x);
+    }
+    return b;
+}
+
+// executes `exe` and returns the path of the JSON file written by it
+std::string execute( std::string const& exe, std::string const& args, boost::filesystem::path const& dir) {
+    const boost::filesystem::path json = dir / ( sanitize( boost::filesystem::path( exe).filename().string() ) + ".json");
+    const std::string cmd = "\"" + exe + "\" " + args + " --json \"" + json.string() + "\"";
+    std::cout << "running " << cmd << std::endl;
+    if ( 0 != std::system( cmd.c_str() ) ) {
+        throw std::runtime_error("benchmark failed: " + exe);
+    }
+    return json.string();
+}
+
+// a result is a regression if its samples are significantly larger than
+// the samples of the baseline (all units are lower-is-better) and the
+// median grew by more than `threshold` percent; results with a single
+// sample (e.g. footprint) can not be tested for significance and are
+// compared by the threshold only
+bool compare( benchmark const& baseline, benchmark const& current, double threshold, double alpha) {
+    bool regression = false;
+    std::cout << current.name << ":" << std::endl;
+    for ( result const& c : current.results) {
+        result const* b = nullptr;
+        for ( result const& x : baseline.results) {
+            if ( x.name == c.name && x.unit == c.unit) {
+                b = & x;
+            }
+        }
+        std::cout << "  " << c.name << " [" << c.unit << "]: ";
+        if ( nullptr == b || b->values.empty() || c.values.empty() ) {
+            std::cout << "no baseline" << std::endl;
+            continue;
+        }
+        const double old_median = compute_statistics( b->values).median;
+        const double new_median = compute_statistics( c.values).median;
+        const double change = 0. != old_median ? 100. * ( new_median - old_median) / old_median : 0.;
+        std::cout << std::fixed << std::setprecision( 1)
+                  << old_median << " -> " << new_median << " (" << std::showpos << change << std::noshowpos << "%";
+        // significance of the change
+        bool slower = true, faster = true;
+        if ( 2 > b->values.size() || 2 > c.values.size() ) {
+            std::cout << ", single sample): ";
+        } else {
+            const mann_whitney_result greater = mann_whitney( b->values, c.values);
+            const mann_whitney_result less = mann_whitney( c.values, b->values);
+            std::cout << ", " << std::setprecision( 4) << "p=" << ( std::min)( greater.p_greater, less.p_greater) << "): ";
+            slower = greater.p_greater < alpha;
+            faster = less.p_greater < alpha;
+        }
+        if ( slower && change > threshold) {
+            std::cout << "REGRESSION";
+            regression = true;
+        } else if ( faster && -change > threshold) {
+            std::cout << "improvement";
+        } else {
+            std::cout << "ok";
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+    return regression;
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string baseline_dir("baselines");
+        std::string flags( build_flags() );
+        std::string args;
+        std::vector< std::string > targets;
+        double threshold = 5.;
+        double alpha = 0.01;
+        bool record = false;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("record", boost::program_options::bool_switch( & record), "store the results as baseline")
+            ("baseline-dir,d", boost::program_options::value< std::string >( & baseline_dir), "directory of the baselines")
+            ("flags,f", boost::program_options::value< std::string >( & flags), "build flags (part of the baseline key)")
+            ("args", boost::program_options::value< std::string >( & args), "arguments passed to each benchmark")
+            ("threshold,t", boost::program_options::value< double >( & threshold), "regression threshold of the median in percent")
+            ("alpha,a", boost::program_options::value< double >( & alpha), "significance level of the Mann-Whitney U test")
+            ("targets", boost::program_options::value< std::vector< std::string > >( & targets), "benchmark executables or JSON results");
+        boost::program_options::positional_options_description pos;
+        pos.add("targets", -1);
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::command_line_parser( argc, argv)
+                    .options( desc)
+                    .positional( pos)
+                    .run(),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") || targets.empty() ) {
+            std::cout << "usage: " << argv[0] << " [options] benchmark ..." << std::endl << desc << std::endl;
+            return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        const std::string key = sanitize( cpu_model() + "-" + flags);
+        const boost::filesystem::path dir = boost::filesystem::path( baseline_dir) / key;
+        const boost::filesystem::path tmp = boost::filesystem::temp_directory_path();
+        std::cout << "baseline: " << dir.string() << std::endl;
+
+        bool regression = false;
+        for ( std::string const& target : targets) {
+            const std::string json = 5 < target.size() && 0 == target.compare( target.size() - 5, 5, ".json")
+                ? target
+                : execute( target, args, tmp);
+            const benchmark current = load( json);
+            const boost::filesystem::path stored = dir / ( sanitize( current.name) + ".json");
+            if ( record) {
+                boost::filesystem::create_directories( dir);
+                std::ifstream in( json.c_str(), std::ios::binary);
+                std::ofstream out( stored.string().c_str(), std::ios::binary | std::ios::trunc);
+                if ( ! ( out << in.rdbuf() ) ) {
+                    throw std::runtime_error("can not write " + stored.string() );
+                }
+                std::cout << "stored " << stored.string() << std::endl;
+            } else if ( ! boost::filesystem::exists( stored) ) {
+                std::cout << current.name << ": no baseline " << stored.string() << std::endl;
+            } else if ( compare( load( stored.string() ), current, threshold, alpha) ) {
+                regression = true;
+            }
+        }
+
+        return regression ? exit_regression : EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,220 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../memory.hpp"
+#include "../stats.hpp"
+
+namespace ctx = boost::context;
+
+// contexts created per sample
+boost::uint64_t jobs = 1000;
+// samples per thread
+boost::uint64_t runs = 100;
+// threads of the parallel measurement (default: one per core)
+unsigned int threads = 0;
+// contexts kept alive to measure the resident memory
+std::size_t live = 1000;
+std::size_t stack_size = ctx::stack_traits::default_size();
+
+// the context-function switches back to the creator and is never
+// resumed again, the context is destroyed while suspended
+template< typename StackAlloc >
+struct allocate {
+    StackAlloc  salloc;
+
+    ctx::execution_context operator()( ctx::execution_context & mctx) const {
+        return ctx::execution_context(
+                std::allocator_arg, salloc,
+                [&mctx]( void *) {
+                    while ( true) {
+                        mctx();
+                    }
+                });
+    }
+};
+
+// user data placed on top of the stack in front of the control
+// structure of the context
+struct control_block {
+    boost::uint64_t     id;
+    char                padding[56];
+};
+
+template< typename StackAlloc >
+struct preallocate {
+    StackAlloc  salloc;
+
+    ctx::execution_context operator()( ctx::execution_context & mctx) const {
+        StackAlloc salloc_( salloc);
+        ctx::stack_context sctx( salloc_.allocate() );
+        void * sp = static_cast< char * >( sctx.sp) - sizeof( control_block);
+        new ( sp) control_block();
+        std::size_t size = sctx.size - sizeof( control_block);
+        // the stack (including the control block) is released by `salloc`
+        return ctx::execution_context(
+                std::allocator_arg, ctx::preallocated( sp, size, sctx), salloc_,
+                [&mctx]( void *) {
+                    while ( true) {
+                        mctx();
+                    }
+                });
+    }
+};
+
+// create + first resume + destroy; returns the duration of the measurement
+template< typename Create >
+duration_type worker( Create const& create, std::atomic< bool > & go, std::vector< double > & samples) {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    samples.reserve( runs);
+    // warm-up of the allocator
+    for ( boost::uint64_t i = 0; i < jobs; ++i) {
+        ctx::execution_context c( create( mctx) );
+        c();
+    }
+    while ( ! go.load( std::memory_order_acquire) ) {
+    }
+    time_point_type begin( clock_type::now() );
+    for ( boost::uint64_t r = 0; r < runs; ++r) {
+        time_point_type start( clock_type::now() );
+        for ( boost::uint64_t i = 0; i < jobs; ++i) {
+            ctx::execution_context c( create( mctx) );
+            c();
+        }
+        duration_type total = clock_type::now() - start;
+        samples.push_back( static_cast< double >( total.count() ) / jobs);
+    }
+    return clock_type::now() - begin;
+}
+
+// resident memory per suspended context
+template< typename Create >
+double memory( Create const& create) {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    std::vector< ctx::execution_context > v;
+    v.reserve( live);
+    const std::size_t before = resident_bytes();
+    for ( std::size_t i = 0; i < live; ++i) {
+        v.push_back( create( mctx) );
+        v.back()();
+    }
+    const std::size_t after = resident_bytes();
+    return after > before ? static_cast< double >( after - before) / live : 0.;
+}
+
+template< typename Create >
+void measure( report & r, std::string const& name, Create const& create) {
+    const unsigned int cores = ( std::max)( 1u, std::thread::hardware_concurrency() );
+    std::vector< unsigned int > nthreads = { 1 };
+    if ( 1 < threads) {
+        nthreads.push_back( threads);
+    }
+    for ( unsigned int n : nthreads) {
+        std::atomic< bool > go( false);
+        std::vector< std::vector< double > > samples( n);
+        std::vector< duration_type > elapsed( n);
+        std::vector< std::thread > workers;
+        for ( unsigned int t = 0; t < n; ++t) {
+            workers.emplace_back( [&,t](){
+                        bind_to_processor( t % cores);
+                        elapsed[t] = worker( create, go, samples[t]);
+                     });
+        }
+        go.store( true, std::memory_order_release);
+        for ( std::thread & w : workers) {
+            w.join();
+        }
+        std::vector< double > all;
+        for ( std::vector< double > const& s : samples) {
+            all.insert( all.end(), s.begin(), s.end() );
+        }
+        // all threads run in parallel, the slowest one determines the throughput
+        const duration_type slowest = * std::max_element( elapsed.begin(), elapsed.end() );
+        std::map< std::string, double > extra;
+        extra["threads"] = n;
+        extra["contexts_per_sec"] = static_cast< double >( n * runs * jobs) * 1e9 / slowest.count();
+        if ( 1 == n) {
+            extra["stack_size"] = static_cast< double >( stack_size);
+            extra["rss_per_context"] = memory( create);
+        }
+        r.add( name + " (" + std::to_string( n) + ( 1 == n ? " thread)" : " threads)"), "ns", all, extra);
+    }
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "contexts created per sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples per thread")
+            ("threads,t", boost::program_options::value< unsigned int >( & threads), "threads of the parallel run (default: one per core)")
+            ("live,l", boost::program_options::value< std::size_t >( & live), "contexts kept alive to measure the memory")
+            ("size,s", boost::program_options::value< std::size_t >( & stack_size), "stack size")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == jobs || 0 == runs || 0 == live) {
+            throw std::invalid_argument("jobs, runs and live must not be zero");
+        }
+        if ( 0 == threads) {
+            threads = ( std::max)( 1u, std::thread::hardware_concurrency() );
+        }
+
+        report r("creation", json, csv);
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+        // execution_context accepts only segmented_stack if segmented stacks are enabled
+        measure( r, "segmented_stack", allocate< ctx::segmented_stack >{ ctx::segmented_stack( stack_size) });
+        measure( r, "preallocated", preallocate< ctx::segmented_stack >{ ctx::segmented_stack( stack_size) });
+#else
+        measure( r, "fixedsize_stack", allocate< ctx::fixedsize_stack >{ ctx::fixedsize_stack( stack_size) });
+        measure( r, "protected_fixedsize_stack", allocate< ctx::protected_fixedsize_stack >{ ctx::protected_fixedsize_stack( stack_size) });
+        measure( r, "preallocated", preallocate< ctx::fixedsize_stack >{ ctx::fixedsize_stack( stack_size) });
+#endif
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -23,4 +23,44 @@
 # include "cycle_i386.hpp"
 #endif
 
+#ifdef BOOST_CONTEXT_CYCLE
+# include <algorithm>
+# include <chrono>
+# include <vector>
+
+// TSC ticks per nanosecond, measured against std::chrono::steady_clock
+// (median of 5 intervals of 20 ms); meaningful only with an invariant TSC
+inline
+double calibrate_tsc()
+{
+    typedef std::chrono::steady_clock   steady;
+    std::vector< double > ratio;
+    for ( int i = 0; i < 5; ++i) {
+        const steady::time_point begin( steady::now() );
+        const cycle_type start( cycles_start() );
+        steady::time_point end;
+        do {
+            end = steady::now();
+        } while ( end - begin < std::chrono::milliseconds( 20) );
+        const cycle_type stop( cycles_stop() );
+        ratio.push_back(
+            static_cast< double >( stop - start) /
+            std::chrono::duration_cast< std::chrono::nanoseconds >( end - begin).count() );
+    }
+    std::sort( ratio.begin(), ratio.end() );
+    return ratio[ratio.size() / 2];
+}
+
+inline
+double tsc_per_ns()
+{
+    static const double ratio = calibrate_tsc();
+    return ratio;
+}
+
+inline
+double cycles_to_ns( double c)
+{ return c / tsc_per_ns(); }
+#endif
+
 #endif // CYCLE_H
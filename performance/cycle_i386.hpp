@@ -8,12 +8,9 @@
 #define CYCLE_I386_H
 
 #include <algorithm>
-#include <numeric>
 #include <cstddef>
-#include <vector>
+#include <limits>
 
-#include <boost/assert.hpp>
-#include <boost/bind.hpp>
 #include <boost/cstdint.hpp>
 
 #define BOOST_CONTEXT_CYCLE
@@ -58,26 +55,30 @@ cycle_type cycles()
 # error "this compiler is not supported"
 #endif
 
-struct cycle_overhead
-{
-    cycle_type operator()()
-    {
-        cycle_type start( cycles() );
-        return cycles() - start;
-    }
-};
+inline
+cycle_type cycles_start()
+{ return cycles(); }
+
+inline
+cycle_type cycles_stop()
+{ return cycles(); }
+
+// not detected on i386; cycles can not be converted to time reliably
+inline
+bool invariant_tsc()
+{ return false; }
 
+// minimum of back-to-back measurements; the average would include
+// interrupts and migrations
 inline
 cycle_type overhead_cycle()
 {
-    std::size_t iterations( 10);
-    std::vector< cycle_type >  overhead( iterations, 0);
-    for ( std::size_t i( 0); i < iterations; ++i)
-        std::generate(
-            overhead.begin(), overhead.end(),
-            cycle_overhead() );
-    BOOST_ASSERT( overhead.begin() != overhead.end() );
-    return std::accumulate( overhead.begin(), overhead.end(), 0) / iterations;
+    cycle_type overhead = ( std::numeric_limits< cycle_type >::max)();
+    for ( std::size_t i = 0; i < 1000; ++i) {
+        cycle_type start( cycles_start() );
+        overhead = ( std::min)( overhead, cycles_stop() - start);
+    }
+    return overhead;
 }
 
 #endif // CYCLE_I386_H
@@ -1,4 +1,3 @@
-
 //          Copyright Oliver Kowalke 2009.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
@@ -8,72 +7,154 @@
 #define CYCLE_X86_64_H
 
 #include <algorithm>
-#include <numeric>
 #include <cstddef>
-#include <vector>
+#include <limits>
 
-#include <boost/assert.hpp>
-#include <boost/bind.hpp>
 #include <boost/cstdint.hpp>
 
 #define BOOST_CONTEXT_CYCLE
 
 typedef boost::uint64_t cycle_type;
 
+// a measured interval is bracketed by cycles_start() and cycles_stop():
+//   lfence; rdtsc; lfence  - prior instructions have completed before the
+//                            TSC is read, later ones do not start before
+//   rdtscp; lfence         - rdtscp waits for prior instructions, lfence
+//                            keeps later instructions behind the read
+// lfence is much cheaper than cpuid and does not trap under virtualization
+
 #if _MSC_VER >= 1400
 # include <intrin.h>
+# include <emmintrin.h>
 # pragma intrinsic(__rdtsc)
+# pragma intrinsic(__rdtscp)
+# pragma intrinsic(__cpuid)
+
 inline
-cycle_type cycles()
-{ return __rdtsc(); }
-#elif defined(__INTEL_COMPILER) || defined(__ICC) || defined(_ECC) || defined(__ICL)
-inline
-cycle_type cycles()
-{ return __rdtsc(); }
-#elif defined(__GNUC__) || defined(__SUNPRO_C)
+void cpuid( boost::uint32_t leaf, boost::uint32_t regs[4])
+{
+    int r[4];
+    __cpuid( r, static_cast< int >( leaf) );
+    for ( int i = 0; i < 4; ++i) {
+        regs[i] = static_cast< boost::uint32_t >( r[i]);
+    }
+}
+
 inline
-cycle_type cycles()
+cycle_type rdtsc_fenced()
 {
-    boost::uint32_t lo, hi;
+    _mm_lfence();
+    cycle_type c = __rdtsc();
+    _mm_lfence();
+    return c;
+}
 
+inline
+cycle_type rdtscp_fenced()
+{
+    unsigned int aux;
+    cycle_type c = __rdtscp( & aux);
+    _mm_lfence();
+    return c;
+}
+#elif defined(__GNUC__) || defined(__SUNPRO_C) || \
+      defined(__INTEL_COMPILER) || defined(__ICC) || defined(_ECC) || defined(__ICL)
+inline
+void cpuid( boost::uint32_t leaf, boost::uint32_t regs[4])
+{
     __asm__ __volatile__ (
-        "xorl %%eax, %%eax\n"
-        "cpuid\n"
-        ::: "%rax", "%rbx", "%rcx", "%rdx"
+        "cpuid"
+        : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+        : "a" (leaf), "c" (0)
     );
-    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi) );
+}
+
+inline
+cycle_type rdtsc_fenced()
+{
+    boost::uint32_t lo, hi;
     __asm__ __volatile__ (
-        "xorl %%eax, %%eax\n"
-        "cpuid\n"
-        ::: "%rax", "%rbx", "%rcx", "%rdx"
+        "lfence\n"
+        "rdtsc\n"
+        "lfence\n"
+        : "=a" (lo), "=d" (hi)
+        :: "memory"
     );
+    return ( cycle_type)hi << 32 | lo;
+}
 
-    return ( cycle_type)hi << 32 | lo; 
+inline
+cycle_type rdtscp_fenced()
+{
+    boost::uint32_t lo, hi;
+    __asm__ __volatile__ (
+        "rdtscp\n"
+        "lfence\n"
+        : "=a" (lo), "=d" (hi)
+        :: "%rcx", "memory"
+    );
+    return ( cycle_type)hi << 32 | lo;
 }
 #else
 # error "this compiler is not supported"
 #endif
 
-struct cycle_overhead
+// CPUID.80000001H:EDX[27]
+inline
+bool has_rdtscp()
 {
-    cycle_type operator()()
-    {
-        cycle_type start( cycles() );
-        return cycles() - start;
-    }
-};
+    static const bool supported = [](){
+        boost::uint32_t regs[4];
+        cpuid( 0x80000000, regs);
+        if ( 0x80000001 > regs[0]) {
+            return false;
+        }
+        cpuid( 0x80000001, regs);
+        return 0 != ( regs[3] & ( 1u << 27) );
+    }();
+    return supported;
+}
+
+// CPUID.80000007H:EDX[8]; the TSC ticks at a constant rate, independent
+// of frequency scaling and C-states, and can be converted to time
+inline
+bool invariant_tsc()
+{
+    static const bool supported = [](){
+        boost::uint32_t regs[4];
+        cpuid( 0x80000000, regs);
+        if ( 0x80000007 > regs[0]) {
+            return false;
+        }
+        cpuid( 0x80000007, regs);
+        return 0 != ( regs[3] & ( 1u << 8) );
+    }();
+    return supported;
+}
 
+inline
+cycle_type cycles_start()
+{ return rdtsc_fenced(); }
+
+inline
+cycle_type cycles_stop()
+{ return has_rdtscp() ? rdtscp_fenced() : rdtsc_fenced(); }
+
+inline
+cycle_type cycles()
+{ return cycles_start(); }
+
+// minimum of back-to-back measurements; the average would include
+// interrupts and migrations
 inline
 cycle_type overhead_cycle()
 {
-    std::size_t iterations( 10);
-    std::vector< cycle_type >  overhead( iterations, 0);
-    for ( std::size_t i( 0); i < iterations; ++i)
-        std::generate(
-            overhead.begin(), overhead.end(),
-            cycle_overhead() );
-    BOOST_ASSERT( overhead.begin() != overhead.end() );
-    return std::accumulate( overhead.begin(), overhead.end(), 0) / iterations;
+    cycle_type overhead = ( std::numeric_limits< cycle_type >::max)();
+    for ( std::size_t i = 0; i < 1000; ++i) {
+        cycle_type start( cycles_start() );
+        overhead = ( std::min)( overhead, cycles_stop() - start);
+    }
+    return overhead;
 }
 
 #endif // CYCLE_X86_64_H
@@ -0,0 +1,185 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../cycle.hpp"
+#include "../perf_counters.hpp"
+#include "../stats.hpp"
+
+// round trips per sample, 0: chosen such that the overhead of the
+// measurement stays below 1% (batch mode)
+boost::uint64_t jobs = 0;
+// samples
+boost::uint64_t runs = 1000;
+// read hardware performance counters
+bool counters = false;
+
+// `fn` executes a sample of `jobs` round trips between the main context
+// and `ectx` (2 * jobs context switches)
+template< typename Fn >
+std::vector< double > measure_time( Fn && fn) {
+    const duration_type overhead = overhead_clock();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    // cache warm-up
+    fn();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        time_point_type start( clock_type::now() );
+        fn();
+        duration_type total = clock_type::now() - start;
+        total -= overhead; // overhead of measurement
+        samples.push_back( static_cast< double >( total.count() ) / ( 2 * jobs) );
+    }
+    return samples;
+}
+
+// hardware counters per context switch over all samples
+template< typename Fn >
+std::map< std::string, double > measure_counters( perf_counters & pc, Fn && fn) {
+    fn();
+    pc.start();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        fn();
+    }
+    pc.stop();
+    return pc.read( static_cast< double >( 2 * jobs * runs) );
+}
+
+#ifdef BOOST_CONTEXT_CYCLE
+template< typename Fn >
+std::vector< double > measure_cycles( Fn && fn) {
+    const cycle_type overhead = overhead_cycle();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    fn();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        cycle_type start( cycles_start() );
+        fn();
+        cycle_type total = cycles_stop() - start;
+        total -= overhead; // overhead of measurement
+        samples.push_back( static_cast< double >( total) / ( 2 * jobs) );
+    }
+    return samples;
+}
+#endif
+
+void run( report & r, perf_counters * pc, std::string const& name, bool preserve_fpu) {
+    boost::context::execution_context mctx( boost::context::execution_context::current() );
+    boost::context::execution_context ectx(
+        [&mctx,preserve_fpu]( void *) {
+            while ( true) {
+                mctx( nullptr, preserve_fpu);
+            }
+        });
+    // start the context-function
+    ectx( nullptr, preserve_fpu);
+    auto sample = [&ectx,preserve_fpu](){
+        for ( boost::uint64_t i = 0; i < jobs; ++i) {
+            ectx( nullptr, preserve_fpu);
+        }
+    };
+    if ( 0 == jobs) {
+        // estimate the cost of a round trip with a short batch
+        jobs = 100;
+        sample();
+        time_point_type start( clock_type::now() );
+        sample();
+        const double per_op = static_cast< double >( ( clock_type::now() - start).count() ) / jobs;
+        jobs = batch_size( static_cast< double >( overhead_clock().count() ), per_op);
+        r.out() << "batch mode: " << jobs << " round trips per sample" << std::endl;
+    }
+    std::map< std::string, double > extra;
+    if ( nullptr != pc) {
+        extra = measure_counters( * pc, sample);
+    }
+    r.add( name, "ns", measure_time( sample), extra);
+#ifdef BOOST_CONTEXT_CYCLE
+    // TSC ticks; converted to ns with the calibrated TSC frequency the
+    // results are comparable to the clock based measurement
+    std::vector< double > c = measure_cycles( sample);
+    std::map< std::string, double > tsc;
+    tsc["tsc_ghz"] = tsc_per_ns();
+    tsc["invariant_tsc"] = invariant_tsc() ? 1. : 0.;
+    r.add( name, "cycles", c, tsc);
+    if ( invariant_tsc() ) {
+        for ( double & v : c) {
+            v = cycles_to_ns( v);
+        }
+        r.add( name, "ns (tsc)", c);
+    }
+#endif
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        bind_to_processor( 0);
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "round trips per sample (0: batch mode, overhead below 1%)")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("counters,p", boost::program_options::bool_switch( & counters), "read hardware performance counters")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == runs) {
+            throw std::invalid_argument("runs must not be zero");
+        }
+
+        std::unique_ptr< perf_counters > pc;
+        if ( counters) {
+            pc.reset( new perf_counters() );
+            if ( ! pc->available() ) {
+                // cycles are still measured by rdtsc
+                std::cerr << "hardware performance counters not available, measuring cycles only" << std::endl;
+                pc.reset();
+            }
+        }
+
+        report r("execution_context", json, csv);
+        run( r, pc.get(), "execution_context", false);
+        run( r, pc.get(), "execution_context (preserve fpu)", true);
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -8,6 +8,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <boost/context/all.hpp>
 #include <boost/cstdint.hpp>
@@ -16,13 +18,17 @@
 #include "../bind_processor.hpp"
 #include "../clock.hpp"
 #include "../cycle.hpp"
+#include "../stats.hpp"
 #include "../../example/simple_stack_allocator.hpp"
 
 typedef boost::context::simple_stack_allocator<
             8 * 1024 * 1024, 64 * 1024, 8 * 1024
         >                                       stack_allocator;
 
+// round trips per sample
 boost::uint64_t jobs = 1000;
+// samples
+boost::uint64_t runs = 100;
 
 struct transfer_t {
     void                    *   data;
@@ -38,57 +44,50 @@ static void foo( intptr_t data) {
     }
 }
 
-duration_type measure_time_fc() {
-    stack_allocator stack_alloc;
-    boost::context::fcontext_t fctx = boost::context::make_fcontext(
-            stack_alloc.allocate( stack_allocator::default_stacksize() ),
-            stack_allocator::default_stacksize(),
-            foo);
-
-    transfer_t t = { 0, 0 };
-    // cache warum-up
-    transfer_t * t_ = reinterpret_cast< transfer_t * >(
-            boost::context::jump_fcontext( & t.fctx, fctx, reinterpret_cast< intptr_t >( & t) ) );
-        
-    time_point_type start( clock_type::now() );
+// transfer record of the suspended context-function
+transfer_t * t_ = nullptr;
+
+void sample() {
     for ( std::size_t i = 0; i < jobs; ++i) {
         transfer_t t = { 0, 0 };
         t_ = reinterpret_cast< transfer_t * >(
                 boost::context::jump_fcontext( & t.fctx, t_->fctx, reinterpret_cast< intptr_t >( & t) ) );
     }
-    duration_type total = clock_type::now() - start;
-    total -= overhead_clock(); // overhead of measurement
-    total /= jobs;  // loops
-    total /= 2;  // 2x jump_fcontext
+}
 
-    return total;
+std::vector< double > measure_time_fc() {
+    const duration_type overhead = overhead_clock();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    // cache warm-up
+    sample();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        time_point_type start( clock_type::now() );
+        sample();
+        duration_type total = clock_type::now() - start;
+        total -= overhead; // overhead of measurement
+        // 2x jump_fcontext per loop
+        samples.push_back( static_cast< double >( total.count() ) / ( 2 * jobs) );
+    }
+    return samples;
 }
 
 #ifdef BOOST_CONTEXT_CYCLE
-cycle_type measure_cycles_fc() {
-    stack_allocator stack_alloc;
-    boost::context::fcontext_t fctx = boost::context::make_fcontext(
-            stack_alloc.allocate( stack_allocator::default_stacksize() ),
-            stack_allocator::default_stacksize(),
-            foo);
-
-    transfer_t t = { 0, 0 };
-    // cache warum-up
-    transfer_t * t_ = reinterpret_cast< transfer_t * >(
-            boost::context::jump_fcontext( & t.fctx, fctx, reinterpret_cast< intptr_t >( & t) ) );
-        
-    cycle_type start( cycles() );
-    for ( std::size_t i = 0; i < jobs; ++i) {
-        transfer_t t = { 0, 0 };
-        t_ = reinterpret_cast< transfer_t * >(
-                boost::context::jump_fcontext( & t.fctx, t_->fctx, reinterpret_cast< intptr_t >( & t) ) );
+std::vector< double > measure_cycles_fc() {
+    const cycle_type overhead = overhead_cycle();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    // cache warm-up
+    sample();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        cycle_type start( cycles_start() );
+        sample();
+        cycle_type total = cycles_stop() - start;
+        total -= overhead; // overhead of measurement
+        // 2x jump_fcontext per loop
+        samples.push_back( static_cast< double >( total) / ( 2 * jobs) );
     }
-    cycle_type total = cycles() - start;
-    total -= overhead_cycle(); // overhead of measurement
-    total /= jobs;  // loops
-    total /= 2;  // 2x jump_fcontext
-
-    return total;
+    return samples;
 }
 #endif
 
@@ -96,12 +95,17 @@ int main( int argc, char * argv[])
 {
     try
     {
+        std::string json, csv;
+
         bind_to_processor( 0);
 
         boost::program_options::options_description desc("allowed options");
         desc.add_options()
             ("help", "help message")
-            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "jobs to run");
+            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "round trips per sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
 
         boost::program_options::variables_map vm;
         boost::program_options::store(
@@ -116,13 +120,26 @@ int main( int argc, char * argv[])
             std::cout << desc << std::endl;
             return EXIT_SUCCESS;
         }
- 
-        boost::uint64_t res = measure_time_fc().count();
-        std::cout << "fcontext_t: average of " << res << " nano seconds" << std::endl;
+        if ( 0 == jobs || 0 == runs) {
+            throw std::invalid_argument("jobs and runs must not be zero");
+        }
+
+        stack_allocator stack_alloc;
+        boost::context::fcontext_t fctx = boost::context::make_fcontext(
+                stack_alloc.allocate( stack_allocator::default_stacksize() ),
+                stack_allocator::default_stacksize(),
+                foo);
+        transfer_t t = { 0, 0 };
+        // start the context-function
+        t_ = reinterpret_cast< transfer_t * >(
+                boost::context::jump_fcontext( & t.fctx, fctx, reinterpret_cast< intptr_t >( & t) ) );
+
+        report r("fcontext", json, csv);
+        r.add( "fcontext_t", "ns", measure_time_fc() );
 #ifdef BOOST_CONTEXT_CYCLE
-        res = measure_cycles_fc();
-        std::cout << "fcontext_t: average of " << res << " cpu cycles" << std::endl;
+        r.add( "fcontext_t", "cycles", measure_cycles_fc() );
 #endif
+        r.write();
 
         return EXIT_SUCCESS;
     }
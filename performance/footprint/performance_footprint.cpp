@@ -0,0 +1,139 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../memory.hpp"
+#include "../stats.hpp"
+
+namespace ctx = boost::context;
+
+// suspended contexts the footprint is measured with
+std::size_t contexts = 10000;
+// upper bound of the search for the maximum number of contexts
+// (0 disables the search); the bound protects against the OOM killer
+std::size_t max_contexts = 100000;
+std::size_t stack_size = ctx::stack_traits::default_size();
+
+double per_context( std::size_t before, std::size_t after, std::size_t n) {
+    return after > before ? static_cast< double >( after - before) / n : 0.;
+}
+
+template< typename StackAlloc >
+void measure( report & r, std::string const& name, StackAlloc salloc) {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    std::vector< ctx::execution_context > v;
+    v.reserve( ( std::max)( contexts, max_contexts) );
+    // the context is suspended after it has been resumed once; its
+    // context-function has touched the top of the stack
+    auto create = [&](){
+        v.emplace_back(
+            std::allocator_arg, salloc,
+            [&mctx]( void *) {
+                while ( true) {
+                    mctx();
+                }
+            });
+        v.back()();
+    };
+
+    const memory_usage before = current_memory_usage();
+    for ( std::size_t i = 0; i < contexts; ++i) {
+        create();
+    }
+    const memory_usage after = current_memory_usage();
+
+    std::map< std::string, double > extra;
+    extra["contexts"] = static_cast< double >( contexts);
+    extra["stack_size"] = static_cast< double >( stack_size);
+    extra["pss_per_context"] = per_context( before.pss, after.pss, contexts);
+    extra["page_tables_per_context"] = per_context( before.page_tables, after.page_tables, contexts);
+    extra["mappings_per_context"] = per_context( before.mappings, after.mappings, contexts);
+
+    // create contexts until the allocation fails or the bound is reached
+    if ( 0 < max_contexts) {
+        bool failed = false;
+        try {
+            while ( v.size() < max_contexts) {
+                create();
+            }
+        } catch ( std::bad_alloc const&) {
+            failed = true;
+        } catch ( std::system_error const&) {
+            failed = true;
+        }
+        extra["max_contexts"] = static_cast< double >( v.size() );
+        extra["max_contexts_failed"] = failed ? 1. : 0.;
+    }
+    v.clear();
+
+    r.add( name, "bytes", std::vector< double >( 1, per_context( before.rss, after.rss, contexts) ), extra);
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("contexts,c", boost::program_options::value< std::size_t >( & contexts), "suspended contexts")
+            ("max,m", boost::program_options::value< std::size_t >( & max_contexts), "upper bound of the search for the maximum number of contexts (0: no search)")
+            ("size,s", boost::program_options::value< std::size_t >( & stack_size), "stack size")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == contexts) {
+            throw std::invalid_argument("contexts must not be zero");
+        }
+
+        // resident bytes per context; RSS/PSS from /proc/self/smaps_rollup,
+        // page tables from /proc/self/status, mappings from /proc/self/maps
+        report r("footprint", json, csv);
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+        // execution_context accepts only segmented_stack if segmented stacks are enabled
+        measure( r, "segmented_stack", ctx::segmented_stack( stack_size) );
+#else
+        measure( r, "fixedsize_stack", ctx::fixedsize_stack( stack_size) );
+        measure( r, "protected_fixedsize_stack", ctx::protected_fixedsize_stack( stack_size) );
+#endif
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
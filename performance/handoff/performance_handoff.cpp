@@ -0,0 +1,281 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../stats.hpp"
+
+namespace ctx = boost::context;
+
+// round trips per sample
+boost::uint64_t jobs = 1000;
+// samples
+boost::uint64_t runs = 100;
+// both threads share one core
+bool single_core = false;
+
+// single-producer/single-consumer ring buffer
+template< typename T, std::size_t Capacity = 64 >
+class spsc_queue {
+private:
+    alignas( 64) std::atomic< std::size_t > head_{ 0 };
+    alignas( 64) std::atomic< std::size_t > tail_{ 0 };
+    T                                       slots_[Capacity];
+
+public:
+    bool push( T const& v) noexcept {
+        const std::size_t t = tail_.load( std::memory_order_relaxed);
+        if ( Capacity == t - head_.load( std::memory_order_acquire) ) {
+            return false;
+        }
+        slots_[t % Capacity] = v;
+        tail_.store( t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop( T & v) noexcept {
+        const std::size_t h = head_.load( std::memory_order_relaxed);
+        if ( h == tail_.load( std::memory_order_acquire) ) {
+            return false;
+        }
+        v = slots_[h % Capacity];
+        head_.store( h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// the ping side executes `jobs` round trips per sample, preceded by one
+// batch for warm-up; `round_trip( v)` sends `v` and returns the answer
+template< typename Fn >
+std::vector< double > ping( Fn && round_trip) {
+    std::vector< double > samples;
+    samples.reserve( runs);
+    boost::uint64_t v = 0;
+    for ( boost::uint64_t r = 0; r <= runs; ++r) {
+        time_point_type start( clock_type::now() );
+        for ( boost::uint64_t i = 0; i < jobs; ++i) {
+            const boost::uint64_t answer = round_trip( v);
+            if ( answer != v + 1) {
+                throw std::logic_error("wrong answer");
+            }
+            v = answer;
+        }
+        duration_type total = clock_type::now() - start;
+        if ( 0 < r) {
+            samples.push_back( static_cast< double >( total.count() ) / jobs);
+        }
+    }
+    return samples;
+}
+
+// round trips of the pong side
+boost::uint64_t messages() {
+    return ( runs + 1) * jobs;
+}
+
+// (a) two contexts on one thread, the message is passed by the context switch
+std::vector< double > measure_contexts() {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context pong(
+        [&mctx]( void * vp) {
+            while ( true) {
+                boost::uint64_t * v = static_cast< boost::uint64_t * >( vp);
+                ++( * v);
+                vp = mctx( v);
+            }
+        });
+    return ping( [&pong]( boost::uint64_t v) {
+                    return * static_cast< boost::uint64_t * >( pong( & v) );
+                 });
+}
+
+// a polling context yields to its scheduler; on a single core the
+// thread has to give up the core too, otherwise the other thread would not
+// run before the end of the time slice
+void relax( ctx::scheduler * sched) {
+    sched->yield();
+    if ( single_core) {
+        std::this_thread::yield();
+    }
+}
+
+// (b) one context on each of two pinned threads; the receiving context
+// polls a lock-free queue and yields to its scheduler while it is empty
+std::vector< double > measure_queue( unsigned int cpu) {
+    spsc_queue< boost::uint64_t > ping_q, pong_q;
+    std::thread t( [&ping_q,&pong_q,cpu](){
+                bind_to_processor( cpu);
+                ctx::scheduler s;
+                s.spawn( [&ping_q,&pong_q](){
+                            ctx::scheduler * sched = ctx::scheduler::current();
+                            for ( boost::uint64_t i = 0; i < messages(); ++i) {
+                                boost::uint64_t v;
+                                while ( ! ping_q.pop( v) ) {
+                                    relax( sched);
+                                }
+                                while ( ! pong_q.push( v + 1) ) {
+                                    relax( sched);
+                                }
+                            }
+                         });
+                s.run();
+             });
+    std::vector< double > samples;
+    ctx::scheduler s;
+    s.spawn( [&ping_q,&pong_q,&samples](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                samples = ping( [&ping_q,&pong_q,sched]( boost::uint64_t v) {
+                                    while ( ! ping_q.push( v) ) {
+                                        relax( sched);
+                                    }
+                                    while ( ! pong_q.pop( v) ) {
+                                        relax( sched);
+                                    }
+                                    return v;
+                                });
+             });
+    s.run();
+    t.join();
+    return samples;
+}
+
+// (b') one context on each of two pinned threads connected by channels;
+// a blocked context suspends, its scheduler sleeps on a futex until the
+// other thread wakes it
+std::vector< double > measure_channel( unsigned int cpu) {
+    ctx::channel< boost::uint64_t > ping_ch( 1), pong_ch( 1);
+    std::thread t( [&ping_ch,&pong_ch,cpu](){
+                bind_to_processor( cpu);
+                ctx::scheduler s;
+                s.spawn( [&ping_ch,&pong_ch](){
+                            for ( boost::uint64_t i = 0; i < messages(); ++i) {
+                                boost::uint64_t v;
+                                ping_ch.pop( v);
+                                pong_ch.push( v + 1);
+                            }
+                         });
+                s.run();
+             });
+    std::vector< double > samples;
+    ctx::scheduler s;
+    s.spawn( [&ping_ch,&pong_ch,&samples](){
+                samples = ping( [&ping_ch,&pong_ch]( boost::uint64_t v) {
+                                    ping_ch.push( v);
+                                    pong_ch.pop( v);
+                                    return v;
+                                });
+             });
+    s.run();
+    t.join();
+    return samples;
+}
+
+// (c) two threads, std::condition_variable
+std::vector< double > measure_threads( unsigned int cpu) {
+    std::mutex mtx;
+    std::condition_variable cond;
+    boost::uint64_t value = 0;
+    // true if `value` is a request
+    bool request = false;
+    std::thread t( [&,cpu](){
+                bind_to_processor( cpu);
+                for ( boost::uint64_t i = 0; i < messages(); ++i) {
+                    std::unique_lock< std::mutex > lk( mtx);
+                    cond.wait( lk, [&request](){ return request; });
+                    ++value;
+                    request = false;
+                    cond.notify_one();
+                }
+             });
+    std::vector< double > samples = ping( [&]( boost::uint64_t v) {
+                    std::unique_lock< std::mutex > lk( mtx);
+                    value = v;
+                    request = true;
+                    cond.notify_one();
+                    cond.wait( lk, [&request](){ return ! request; });
+                    return value;
+                });
+    t.join();
+    return samples;
+}
+
+void add( report & r, std::string const& name, std::vector< double > const& samples) {
+    std::map< std::string, double > extra;
+    double sum = 0.;
+    for ( double s : samples) {
+        sum += s;
+    }
+    extra["round_trips_per_sec"] = 1e9 * samples.size() / sum;
+    r.add( name, "ns", samples, extra);
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "round trips per sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == jobs || 0 == runs) {
+            throw std::invalid_argument("jobs and runs must not be zero");
+        }
+
+        // the pong side runs on a second core if there is one
+        single_core = 1 >= std::thread::hardware_concurrency();
+        const unsigned int cpu = single_core ? 0 : 1;
+        bind_to_processor( 0);
+
+        report r("handoff", json, csv);
+        add( r, "execution_context (one thread)", measure_contexts() );
+        add( r, "contexts + lock-free queue (two threads)", measure_queue( cpu) );
+        add( r, "contexts + channel (two threads)", measure_channel( cpu) );
+        add( r, "std::thread + std::condition_variable", measure_threads( cpu) );
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
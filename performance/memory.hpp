@@ -0,0 +1,91 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <boost/config.hpp>
+
+#if defined(__linux__)
+# include <unistd.h>
+#endif
+
+// resident set size of the process in bytes, 0 if not supported
+inline
+std::size_t resident_bytes()
+{
+#if defined(__linux__)
+    // second field of /proc/self/statm: resident pages
+    std::ifstream is("/proc/self/statm");
+    std::size_t size = 0, resident = 0;
+    if ( is >> size >> resident) {
+        return resident * static_cast< std::size_t >( ::sysconf( _SC_PAGESIZE) );
+    }
+#endif
+    return 0;
+}
+
+// memory of the process including the kernel-side cost; fields not
+// supported by the platform are 0
+struct memory_usage
+{
+    // resident set size
+    std::size_t     rss;
+    // proportional set size (shared pages divided by the number of sharers)
+    std::size_t     pss;
+    // page tables
+    std::size_t     page_tables;
+    // number of memory mappings (VMAs)
+    std::size_t     mappings;
+};
+
+#if defined(__linux__)
+// value of `key` (in kB) of a /proc file in the format "Key:   123 kB"
+inline
+std::size_t proc_kb( char const* path, std::string const& key)
+{
+    std::ifstream is( path);
+    std::string line;
+    while ( std::getline( is, line) ) {
+        if ( 0 == line.compare( 0, key.size(), key) ) {
+            std::istringstream ls( line.substr( key.size() ) );
+            std::size_t kb = 0;
+            ls >> kb;
+            return kb * 1024;
+        }
+    }
+    return 0;
+}
+#endif
+
+inline
+memory_usage current_memory_usage()
+{
+    memory_usage m = { 0, 0, 0, 0 };
+#if defined(__linux__)
+    // smaps_rollup requires Linux 4.14
+    m.rss = proc_kb( "/proc/self/smaps_rollup", "Rss:");
+    m.pss = proc_kb( "/proc/self/smaps_rollup", "Pss:");
+    if ( 0 == m.rss) {
+        m.rss = resident_bytes();
+    }
+    m.page_tables = proc_kb( "/proc/self/status", "VmPTE:");
+    std::ifstream is("/proc/self/maps");
+    std::string line;
+    while ( std::getline( is, line) ) {
+        ++m.mappings;
+    }
+#else
+    m.rss = resident_bytes();
+#endif
+    return m;
+}
+
+#endif // MEMORY_H
@@ -0,0 +1,146 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../stats.hpp"
+
+// contexts per core
+std::vector< unsigned int > contexts = { 1, 4, 16, 64 };
+unsigned int threads = 0;
+// lock/unlock per context and sample
+boost::uint64_t iterations = 10000;
+// samples
+boost::uint64_t runs = 10;
+// increments inside the critical section
+unsigned int work = 16;
+
+volatile boost::uint64_t shared = 0;
+
+template< typename Mutex >
+void critical_section( Mutex & mtx) {
+    std::unique_lock< Mutex > lk( mtx);
+    for ( unsigned int i = 0; i < work; ++i) {
+        shared = shared + 1;
+    }
+}
+
+// every context acquires the mutex `iterations` times and yields after
+// each critical section; a std::mutex blocks the whole thread if
+// contended by a context of another thread
+template< typename Mutex >
+duration_type measure_once( unsigned int per_core) {
+    Mutex mtx;
+    const unsigned int cores = ( std::max)( 1u, std::thread::hardware_concurrency() );
+    std::vector< std::thread > workers;
+    time_point_type start( clock_type::now() );
+    for ( unsigned int t = 0; t < threads; ++t) {
+        workers.emplace_back( [&mtx,per_core,cores,t](){
+                    bind_to_processor( t % cores);
+                    boost::context::scheduler s;
+                    for ( unsigned int c = 0; c < per_core; ++c) {
+                        s.spawn( [&mtx](){
+                                    boost::context::scheduler * sched = boost::context::scheduler::current();
+                                    for ( boost::uint64_t i = 0; i < iterations; ++i) {
+                                        critical_section( mtx);
+                                        sched->yield();
+                                    }
+                                 });
+                    }
+                    s.run();
+                 });
+    }
+    for ( std::thread & w : workers) {
+        w.join();
+    }
+    return clock_type::now() - start;
+}
+
+// ns per lock/unlock of each sample
+template< typename Mutex >
+std::vector< double > measure( unsigned int per_core) {
+    const double ops = static_cast< double >( iterations * per_core * threads);
+    std::vector< double > samples;
+    samples.reserve( runs);
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        samples.push_back( measure_once< Mutex >( per_core).count() / ops);
+    }
+    return samples;
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("contexts,c", boost::program_options::value< std::vector< unsigned int > >( & contexts)->multitoken(), "contexts per core")
+            ("threads,t", boost::program_options::value< unsigned int >( & threads), "threads (default: one per core)")
+            ("iterations,i", boost::program_options::value< boost::uint64_t >( & iterations), "lock/unlock per context and sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("work,w", boost::program_options::value< unsigned int >( & work), "increments inside the critical section")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        if ( 0 == iterations || 0 == runs) {
+            throw std::invalid_argument("iterations and runs must not be zero");
+        }
+        if ( 0 == threads) {
+            threads = ( std::max)( 1u, std::thread::hardware_concurrency() );
+        }
+
+        report r("mutex", json, csv);
+        for ( unsigned int per_core : contexts) {
+            std::map< std::string, double > extra;
+            extra["threads"] = threads;
+            extra["contexts_per_core"] = per_core;
+            extra["work"] = work;
+            const std::string suffix = " (" + std::to_string( per_core) + " contexts per core)";
+            // ns per lock/unlock
+            r.add( "boost::context::mutex" + suffix, "ns", measure< boost::context::mutex >( per_core), extra);
+            r.add( "std::mutex" + suffix, "ns", measure< std::mutex >( per_core), extra);
+        }
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
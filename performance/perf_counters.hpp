@@ -0,0 +1,155 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/config.hpp>
+#include <boost/cstdint.hpp>
+
+#if defined(__linux__)
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+// hardware performance counters of the calling thread (user space only),
+// opened as one group so that all counters cover the same instructions;
+// events not supported by the CPU/kernel are skipped, available() returns
+// false if no counter could be opened (e.g. perf_event_paranoid > 2,
+// virtual machines without PMU, non-Linux platforms)
+class perf_counters
+{
+private:
+    struct event
+    {
+        std::string         name;
+        int                 fd;
+    };
+
+    std::vector< event >    events_;
+    int                     leader_;
+
+#if defined(__linux__)
+    static int open_( boost::uint32_t type, boost::uint64_t config, int group)
+    {
+        perf_event_attr attr;
+        std::memset( & attr, 0, sizeof( attr) );
+        attr.size = sizeof( attr);
+        attr.type = type;
+        attr.config = config;
+        // the group is enabled by start()
+        attr.disabled = -1 == group ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast< int >( ::syscall( __NR_perf_event_open, & attr, 0, -1, group, 0) );
+    }
+
+    static boost::uint64_t cache_( boost::uint64_t cache, boost::uint64_t op, boost::uint64_t result)
+    { return cache | ( op << 8) | ( result << 16); }
+
+    void add_( char const* name, boost::uint32_t type, boost::uint64_t config)
+    {
+        int fd = open_( type, config, leader_);
+        if ( -1 == fd) {
+            return;
+        }
+        if ( -1 == leader_) {
+            leader_ = fd;
+        }
+        event e = { name, fd };
+        events_.push_back( e);
+    }
+#endif
+
+public:
+    perf_counters() :
+        events_(),
+        leader_( -1)
+    {
+#if defined(__linux__)
+        add_( "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        if ( -1 == leader_) {
+            // without cycles counter no other hardware counter is usable
+            return;
+        }
+        add_( "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        add_( "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        add_( "l1d_misses", PERF_TYPE_HW_CACHE,
+              cache_( PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) );
+        add_( "llc_misses", PERF_TYPE_HW_CACHE,
+              cache_( PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) );
+        add_( "dtlb_misses", PERF_TYPE_HW_CACHE,
+              cache_( PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) );
+#endif
+    }
+
+    ~perf_counters()
+    {
+#if defined(__linux__)
+        for ( event const& e : events_) {
+            ::close( e.fd);
+        }
+#endif
+    }
+
+    perf_counters( perf_counters const&) = delete;
+    perf_counters & operator=( perf_counters const&) = delete;
+
+    bool available() const
+    { return -1 != leader_; }
+
+    void start()
+    {
+#if defined(__linux__)
+        if ( available() ) {
+            ::ioctl( leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl( leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    void stop()
+    {
+#if defined(__linux__)
+        if ( available() ) {
+            ::ioctl( leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    // counter values since start() divided by `ops`, keyed by event name;
+    // values are scaled if the kernel multiplexed the counters
+    std::map< std::string, double > read( double ops) const
+    {
+        std::map< std::string, double > values;
+#if defined(__linux__)
+        if ( ! available() || 0. >= ops) {
+            return values;
+        }
+        // nr, time enabled, time running, one value per event
+        std::vector< boost::uint64_t > buf( 3 + events_.size(), 0);
+        const ssize_t len = ::read( leader_, & buf[0], buf.size() * sizeof( boost::uint64_t) );
+        if ( len < static_cast< ssize_t >( 3 * sizeof( boost::uint64_t) ) || 0 == buf[2]) {
+            return values;
+        }
+        const double scale = static_cast< double >( buf[1]) / buf[2];
+        for ( std::size_t i = 0; i < buf[0] && i < events_.size(); ++i) {
+            values[events_[i].name] = static_cast< double >( buf[3 + i]) * scale / ops;
+        }
+#endif
+        return values;
+    }
+};
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,154 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../stats.hpp"
+
+namespace ctx = boost::context;
+
+typedef std::chrono::steady_clock   steady_clock;
+
+// latencies measured per variant
+boost::uint64_t samples = 10000;
+// contexts saturating the scheduler
+boost::uint64_t bulk = 16;
+// work of a bulk context between two yields, in microseconds
+boost::uint64_t work = 20;
+// the control context is woken every `period` work items
+boost::uint64_t period = 4;
+
+void burn( steady_clock::duration d) {
+    const steady_clock::time_point end = steady_clock::now() + d;
+    while ( steady_clock::now() < end) {
+    }
+}
+
+enum class variant {
+    fifo,
+    priority,
+    deadline
+};
+
+// `bulk` contexts of priority 0 run `work` and yield, keeping the ready
+// queue saturated; in the middle of every `period`-th work item a bulk
+// context makes the control context ready, which measures the delay until
+// it is resumed
+std::vector< double > measure( variant v) {
+    const steady_clock::duration w = std::chrono::microseconds( work);
+    ctx::scheduler s;
+    ctx::task_handle control;
+    steady_clock::time_point readied;
+    bool stop = false;
+    std::vector< double > latencies;
+    latencies.reserve( samples);
+    ctx::task_attributes attrs;
+    if ( variant::priority == v) {
+        attrs = ctx::task_attributes( ctx::scheduler::max_priority);
+    }
+    s.spawn( attrs, [&](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                for ( boost::uint64_t i = 0; i <= samples; ++i) {
+                    if ( variant::deadline == v) {
+                        // the response is due within one work item
+                        sched->attributes( ctx::task_attributes( 0, steady_clock::now() + w) );
+                    }
+                    control = sched->running();
+                    sched->suspend();
+                    // the first sample warms up
+                    if ( 0 < i) {
+                        latencies.push_back( static_cast< double >(
+                            std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                steady_clock::now() - readied).count() ) );
+                    }
+                }
+                stop = true;
+             });
+    for ( boost::uint64_t b = 0; b < bulk; ++b) {
+        s.spawn( [&,b](){
+                    ctx::scheduler * sched = ctx::scheduler::current();
+                    for ( boost::uint64_t i = 0; ! stop; ++i) {
+                        if ( 0 == b && 0 == i % period && control) {
+                            burn( w / 2);
+                            readied = steady_clock::now();
+                            ctx::task_handle t = control;
+                            control = ctx::task_handle();
+                            sched->ready( t);
+                            burn( w / 2);
+                        } else {
+                            burn( w);
+                        }
+                        sched->yield();
+                    }
+                 });
+    }
+    s.run();
+    return latencies;
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("samples,s", boost::program_options::value< boost::uint64_t >( & samples), "latencies per variant")
+            ("bulk,b", boost::program_options::value< boost::uint64_t >( & bulk), "contexts of the saturating load")
+            ("work,w", boost::program_options::value< boost::uint64_t >( & work), "work between two yields in microseconds")
+            ("period,p", boost::program_options::value< boost::uint64_t >( & period), "work items per wake-up of the control context")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == samples || 0 == bulk || 0 == work || 0 == period) {
+            throw std::invalid_argument("samples, bulk, work and period must not be zero");
+        }
+
+        bind_to_processor( 0);
+
+        std::map< std::string, double > extra;
+        extra["bulk"] = static_cast< double >( bulk);
+        extra["work_us"] = static_cast< double >( work);
+        report r("priority", json, csv);
+        r.add( "wake-up latency, same priority (FIFO)", "ns", measure( variant::fifo), extra);
+        r.add( "wake-up latency, max_priority", "ns", measure( variant::priority), extra);
+        r.add( "wake-up latency, deadline (EDF)", "ns", measure( variant::deadline), extra);
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,303 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+// summary of repeated measurements (one sample per run)
+struct statistics
+{
+    std::size_t     samples;
+    double          min;
+    double          median;
+    double          p99;
+    double          p999;
+    double          max;
+    double          mean;
+    double          stddev;
+};
+
+// nearest-rank percentile of sorted samples
+inline
+double percentile( std::vector< double > const& sorted, double p)
+{
+    BOOST_ASSERT( ! sorted.empty() );
+    std::size_t rank = static_cast< std::size_t >( std::ceil( p * sorted.size() ) );
+    if ( 0 < rank) {
+        --rank;
+    }
+    return sorted[( std::min)( rank, sorted.size() - 1)];
+}
+
+inline
+statistics compute_statistics( std::vector< double > samples)
+{
+    if ( samples.empty() ) {
+        throw std::invalid_argument("no samples");
+    }
+    std::sort( samples.begin(), samples.end() );
+    statistics s;
+    s.samples = samples.size();
+    s.min = samples.front();
+    s.max = samples.back();
+    s.median = percentile( samples, 0.5);
+    s.p99 = percentile( samples, 0.99);
+    s.p999 = percentile( samples, 0.999);
+    s.mean = std::accumulate( samples.begin(), samples.end(), 0.) / samples.size();
+    double sq = 0.;
+    for ( double v : samples) {
+        sq += ( v - s.mean) * ( v - s.mean);
+    }
+    s.stddev = 1 < samples.size() ? std::sqrt( sq / ( samples.size() - 1) ) : 0.;
+    return s;
+}
+
+struct mann_whitney_result
+{
+    // U statistic of the second sample
+    double          u;
+    // normal approximation of U (tie- and continuity-corrected)
+    double          z;
+    // one-sided p-value of H1: values of the second sample tend to be
+    // larger than the values of the first sample
+    double          p_greater;
+};
+
+// Mann-Whitney U test (Wilcoxon rank-sum test); makes no assumption about
+// the distribution of the samples (timings are skewed, not normal)
+inline
+mann_whitney_result mann_whitney( std::vector< double > const& a, std::vector< double > const& b)
+{
+    if ( a.empty() || b.empty() ) {
+        throw std::invalid_argument("no samples");
+    }
+    typedef std::pair< double, std::size_t >    value_type;
+    std::vector< value_type > all;
+    all.reserve( a.size() + b.size() );
+    for ( double v : a) {
+        all.push_back( value_type( v, 0) );
+    }
+    for ( double v : b) {
+        all.push_back( value_type( v, 1) );
+    }
+    std::sort( all.begin(), all.end() );
+    const double n1 = static_cast< double >( a.size() ), n2 = static_cast< double >( b.size() ), n = n1 + n2;
+    // tied values get the average of their ranks
+    double r2 = 0., ties = 0.;
+    for ( std::size_t i = 0; i < all.size(); ) {
+        std::size_t j = i;
+        while ( j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        const double rank = ( i + 1 + j) / 2.;
+        const double t = static_cast< double >( j - i);
+        ties += t * t * t - t;
+        for ( std::size_t k = i; k < j; ++k) {
+            if ( 1 == all[k].second) {
+                r2 += rank;
+            }
+        }
+        i = j;
+    }
+    mann_whitney_result r;
+    r.u = r2 - n2 * ( n2 + 1) / 2;
+    const double mu = n1 * n2 / 2;
+    const double sigma = std::sqrt( n1 * n2 / 12 * ( ( n + 1) - ties / ( n * ( n - 1) ) ) );
+    if ( 0. == sigma) {
+        // all values are equal
+        r.z = 0.;
+        r.p_greater = 0.5;
+        return r;
+    }
+    r.z = ( r.u - mu - 0.5) / sigma;
+    r.p_greater = 0.5 * std::erfc( r.z / std::sqrt( 2.) );
+    return r;
+}
+
+// collects the results of a benchmark; printed human-readable and
+// optionally written as JSON and/or CSV ("-" writes to stdout, the
+// human-readable output goes to stderr in that case)
+class report
+{
+public:
+    struct entry
+    {
+        std::string                         name;
+        std::string                         unit;
+        statistics                          stats;
+        // the samples (used to compare runs)
+        std::vector< double >               values;
+        // additional per-entry values (counters, parameters, ...)
+        std::map< std::string, double >     extra;
+    };
+
+private:
+    std::string             benchmark_;
+    std::vector< entry >    entries_;
+    std::string             json_;
+    std::string             csv_;
+
+    static std::string escape_( std::string const& s)
+    {
+        std::string r;
+        for ( char c : s) {
+            if ( '"' == c || '\\' == c) {
+                r += '\\';
+            }
+            r += c;
+        }
+        return r;
+    }
+
+    // RFC 4180: fields are enclosed in double quotes, embedded double
+    // quotes are doubled
+    static std::string quote_( std::string const& s)
+    {
+        std::string r("\"");
+        for ( char c : s) {
+            if ( '"' == c) {
+                r += '"';
+            }
+            r += c;
+        }
+        return r + "\"";
+    }
+
+    template< typename Fn >
+    void write_( std::string const& path, Fn && fn) const
+    {
+        if ( path.empty() ) {
+            return;
+        }
+        if ( "-" == path) {
+            fn( std::cout);
+            return;
+        }
+        std::ofstream os( path.c_str() );
+        if ( ! os) {
+            throw std::runtime_error("can not open " + path);
+        }
+        fn( os);
+    }
+
+public:
+    explicit report( std::string const& benchmark,
+                     std::string const& json = std::string(), std::string const& csv = std::string() ) :
+        benchmark_( benchmark),
+        entries_(),
+        json_( json),
+        csv_( csv)
+    {}
+
+    // stream of the human-readable output; stdout is reserved for the
+    // machine-readable results if those are written to "-"
+    std::ostream & out() const
+    { return "-" == json_ || "-" == csv_ ? std::cerr : std::cout; }
+
+    // prints the human-readable line of the entry
+    entry const& add( std::string const& name, std::string const& unit, std::vector< double > const& samples,
+                      std::map< std::string, double > const& extra = std::map< std::string, double >() )
+    {
+        entry e;
+        e.name = name;
+        e.unit = unit;
+        e.stats = compute_statistics( samples);
+        e.values = samples;
+        e.extra = extra;
+        entries_.push_back( e);
+        print( out(), entries_.back() );
+        return entries_.back();
+    }
+
+    std::vector< entry > const& entries() const
+    { return entries_; }
+
+    static void print( std::ostream & os, entry const& e)
+    {
+        os << e.name << ": median of " << std::fixed << std::setprecision( 1) << e.stats.median << " " << e.unit
+           << " (min " << e.stats.min << ", p99 " << e.stats.p99 << ", p999 " << e.stats.p999
+           << ", max " << e.stats.max << ", stddev " << e.stats.stddev << ", " << e.stats.samples << " samples)";
+        for ( auto const& x : e.extra) {
+            os << " " << x.first << "=" << x.second;
+        }
+        os << std::defaultfloat << std::endl;
+    }
+
+    void write_json( std::ostream & os) const
+    {
+        os << "{\n  \"benchmark\": \"" << escape_( benchmark_) << "\",\n  \"results\": [";
+        for ( std::size_t i = 0; i < entries_.size(); ++i) {
+            entry const& e = entries_[i];
+            os << ( 0 == i ? "\n" : ",\n")
+               << std::setprecision( 10)
+               << "    { \"name\": \"" << escape_( e.name) << "\", \"unit\": \"" << escape_( e.unit) << "\""
+               << ", \"samples\": " << e.stats.samples
+               << ", \"min\": " << e.stats.min
+               << ", \"median\": " << e.stats.median
+               << ", \"p99\": " << e.stats.p99
+               << ", \"p999\": " << e.stats.p999
+               << ", \"max\": " << e.stats.max
+               << ", \"mean\": " << e.stats.mean
+               << ", \"stddev\": " << e.stats.stddev;
+            for ( auto const& x : e.extra) {
+                os << ", \"" << escape_( x.first) << "\": " << x.second;
+            }
+            os << ", \"values\": [";
+            for ( std::size_t k = 0; k < e.values.size(); ++k) {
+                os << ( 0 == k ? "" : ", ") << e.values[k];
+            }
+            os << "] }";
+        }
+        os << "\n  ]\n}" << std::endl;
+    }
+
+    // one row per entry; extra values are appended as key=value column
+    void write_csv( std::ostream & os) const
+    {
+        os << "benchmark,name,unit,samples,min,median,p99,p999,max,mean,stddev,extra\n";
+        for ( entry const& e : entries_) {
+            os << std::setprecision( 10)
+               << quote_( benchmark_) << "," << quote_( e.name) << ","
+               << quote_( e.unit) << "," << e.stats.samples << ","
+               << e.stats.min << "," << e.stats.median << "," << e.stats.p99 << "," << e.stats.p999 << ","
+               << e.stats.max << "," << e.stats.mean << "," << e.stats.stddev << ",";
+            std::ostringstream extra;
+            extra << std::setprecision( 10);
+            bool first = true;
+            for ( auto const& x : e.extra) {
+                extra << ( first ? "" : ";") << x.first << "=" << x.second;
+                first = false;
+            }
+            os << quote_( extra.str() ) << "\n";
+        }
+        os.flush();
+    }
+
+    // writes the results to the paths passed to the constructor
+    void write() const
+    {
+        write_( json_, [this]( std::ostream & os){ write_json( os); });
+        write_( csv_, [this]( std::ostream & os){ write_csv( os); });
+    }
+};
+
+#endif // STATS_H
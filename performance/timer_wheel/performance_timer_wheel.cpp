@@ -0,0 +1,204 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/context/timer_wheel.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../stats.hpp"
+
+// 1M concurrent timers, most of them cancelled before expiry
+// (the common case of I/O timeouts)
+boost::uint64_t timers = 1000000;
+boost::uint64_t cancel_percent = 90;
+boost::uint64_t max_ticks = 60000;
+// samples
+boost::uint64_t runs = 5;
+
+struct result_type {
+    duration_type   insert;
+    duration_type   cancel;
+    duration_type   expire;
+};
+
+// ns per timer of each sample
+struct samples_type {
+    std::vector< double >   insert;
+    std::vector< double >   cancel;
+    std::vector< double >   expire;
+};
+
+void add( samples_type & s, result_type const& r, boost::uint64_t cancelled) {
+    s.insert.push_back( static_cast< double >( r.insert.count() ) / timers);
+    s.cancel.push_back( 0 < cancelled ? static_cast< double >( r.cancel.count() ) / cancelled : 0.);
+    s.expire.push_back( timers > cancelled ? static_cast< double >( r.expire.count() ) / ( timers - cancelled) : 0.);
+}
+
+void add( report & r, std::string const& name, samples_type const& s, std::map< std::string, double > const& extra) {
+    r.add( name + " insert", "ns", s.insert, extra);
+    r.add( name + " cancel", "ns", s.cancel, extra);
+    r.add( name + " expire", "ns", s.expire, extra);
+}
+
+result_type measure_wheel( std::vector< boost::uint64_t > const& expiry,
+                           std::vector< std::size_t > const& cancelled) {
+    std::vector< boost::context::timer_wheel::timer > t( timers);
+    std::unique_ptr< boost::context::timer_wheel > w( new boost::context::timer_wheel() );
+    result_type r;
+
+    time_point_type start( clock_type::now() );
+    for ( std::size_t i = 0; i < timers; ++i) {
+        w->insert( & t[i], expiry[i]);
+    }
+    r.insert = clock_type::now() - start;
+
+    start = clock_type::now();
+    for ( std::size_t i : cancelled) {
+        w->cancel( & t[i]);
+    }
+    r.cancel = clock_type::now() - start;
+
+    // advance tick by tick, each tick expires one batch
+    boost::uint64_t expired = 0;
+    start = clock_type::now();
+    for ( boost::uint64_t tick = 1; tick <= max_ticks; ++tick) {
+        w->advance( tick);
+        while ( nullptr != w->pop_expired() ) {
+            ++expired;
+        }
+    }
+    r.expire = clock_type::now() - start;
+    if ( expired != timers - cancelled.size() ) {
+        throw std::logic_error("timer_wheel: wrong number of expired timers");
+    }
+    return r;
+}
+
+result_type measure_priority_queue( std::vector< boost::uint64_t > const& expiry,
+                                    std::vector< std::size_t > const& cancelled) {
+    // std::priority_queue<> does not support removal;
+    // cancelled timers are skipped when popped
+    typedef std::pair< boost::uint64_t, std::size_t >   entry_type;
+    std::priority_queue<
+        entry_type, std::vector< entry_type >, std::greater< entry_type >
+    >                                                   q;
+    std::vector< char > dead( timers, 0);
+    result_type r;
+
+    time_point_type start( clock_type::now() );
+    for ( std::size_t i = 0; i < timers; ++i) {
+        q.push( entry_type( expiry[i], i) );
+    }
+    r.insert = clock_type::now() - start;
+
+    start = clock_type::now();
+    for ( std::size_t i : cancelled) {
+        dead[i] = 1;
+    }
+    r.cancel = clock_type::now() - start;
+
+    boost::uint64_t expired = 0;
+    start = clock_type::now();
+    for ( boost::uint64_t tick = 1; tick <= max_ticks; ++tick) {
+        while ( ! q.empty() && q.top().first <= tick) {
+            if ( 0 == dead[q.top().second]) {
+                ++expired;
+            }
+            q.pop();
+        }
+    }
+    r.expire = clock_type::now() - start;
+    if ( expired != timers - cancelled.size() ) {
+        throw std::logic_error("priority_queue: wrong number of expired timers");
+    }
+    return r;
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        bind_to_processor( 0);
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("timers,t", boost::program_options::value< boost::uint64_t >( & timers), "concurrent timers")
+            ("cancel,c", boost::program_options::value< boost::uint64_t >( & cancel_percent), "percentage of cancelled timers")
+            ("ticks,k", boost::program_options::value< boost::uint64_t >( & max_ticks), "range of expiry in ticks")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == timers || 0 == max_ticks || 0 == runs) {
+            throw std::invalid_argument("timers, ticks and runs must not be zero");
+        }
+
+        std::mt19937_64 rng( 42);
+        std::uniform_int_distribution< boost::uint64_t > dist( 1, max_ticks);
+        std::vector< boost::uint64_t > expiry( timers);
+        std::vector< std::size_t > cancelled;
+        for ( std::size_t i = 0; i < timers; ++i) {
+            expiry[i] = dist( rng);
+            if ( rng() % 100 < cancel_percent) {
+                cancelled.push_back( i);
+            }
+        }
+        std::shuffle( cancelled.begin(), cancelled.end(), rng);
+
+        samples_type wheel, queue;
+        for ( boost::uint64_t i = 0; i < runs; ++i) {
+            add( wheel, measure_wheel( expiry, cancelled), cancelled.size() );
+            add( queue, measure_priority_queue( expiry, cancelled), cancelled.size() );
+        }
+
+        std::map< std::string, double > extra;
+        extra["timers"] = static_cast< double >( timers);
+        extra["cancelled"] = static_cast< double >( cancelled.size() );
+        extra["ticks"] = static_cast< double >( max_ticks);
+        report r("timer_wheel", json, csv);
+        add( r, "timer_wheel", wheel, extra);
+        add( r, "std::priority_queue", queue, extra);
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -8,6 +8,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <boost/cstdint.hpp>
 #include <boost/program_options.hpp>
@@ -17,51 +19,64 @@
 #include "../bind_processor.hpp"
 #include "../clock.hpp"
 #include "../cycle.hpp"
+#include "../stats.hpp"
 #include "../../example/simple_stack_allocator.hpp"
 
 typedef boost::context::simple_stack_allocator<
             8 * 1024 * 1024, 64 * 1024, 8 * 1024
         >                                       stack_allocator;
 
+// round trips per sample
 boost::uint64_t jobs = 1000;
+// samples
+boost::uint64_t runs = 100;
 ucontext_t uc, ucm;
 
 static void fn()
 { while ( true) ::swapcontext( & uc, & ucm); }
 
-duration_type measure_time()
+void sample()
 {
-    // cache warum-up
-    ::swapcontext( & ucm, & uc);
-        
-    time_point_type start( clock_type::now() );
     for ( std::size_t i = 0; i < jobs; ++i) {
         ::swapcontext( & ucm, & uc);
     }
-    duration_type total = clock_type::now() - start;
-    total -= overhead_clock(); // overhead of measurement
-    total /= jobs;  // loops
-    total /= 2;  // 2x jump_fcontext
+}
 
-    return total;
+std::vector< double > measure_time()
+{
+    const duration_type overhead = overhead_clock();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    // cache warm-up
+    sample();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        time_point_type start( clock_type::now() );
+        sample();
+        duration_type total = clock_type::now() - start;
+        total -= overhead; // overhead of measurement
+        // 2x swapcontext per loop
+        samples.push_back( static_cast< double >( total.count() ) / ( 2 * jobs) );
+    }
+    return samples;
 }
 
 #ifdef BOOST_CONTEXT_CYCLE
-cycle_type measure_cycles()
+std::vector< double > measure_cycles()
 {
-    // cache warum-up
-    ::swapcontext( & ucm, & uc);
-        
-    cycle_type start( cycles() );
-    for ( std::size_t i = 0; i < jobs; ++i) {
-        ::swapcontext( & ucm, & uc);
+    const cycle_type overhead = overhead_cycle();
+    std::vector< double > samples;
+    samples.reserve( runs);
+    // cache warm-up
+    sample();
+    for ( boost::uint64_t i = 0; i < runs; ++i) {
+        cycle_type start( cycles_start() );
+        sample();
+        cycle_type total = cycles_stop() - start;
+        total -= overhead; // overhead of measurement
+        // 2x swapcontext per loop
+        samples.push_back( static_cast< double >( total) / ( 2 * jobs) );
     }
-    cycle_type total = cycles() - start;
-    total -= overhead_cycle(); // overhead of measurement
-    total /= jobs;  // loops
-    total /= 2;  // 2x jump_fcontext
-
-    return total;
+    return samples;
 }
 #endif
 
@@ -69,12 +84,17 @@ int main( int argc, char * argv[])
 {
     try
     {
+        std::string json, csv;
+
         bind_to_processor( 0);
 
         boost::program_options::options_description desc("allowed options");
         desc.add_options()
             ("help", "help message")
-            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "jobs to run");
+            ("jobs,j", boost::program_options::value< boost::uint64_t >( & jobs), "round trips per sample")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "samples")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
 
         boost::program_options::variables_map vm;
         boost::program_options::store(
@@ -89,19 +109,22 @@ int main( int argc, char * argv[])
             std::cout << desc << std::endl;
             return EXIT_SUCCESS;
         }
+        if ( 0 == jobs || 0 == runs) {
+            throw std::invalid_argument("jobs and runs must not be zero");
+        }
 
         stack_allocator stack_alloc;
         ::getcontext( & uc);
         uc.uc_stack.ss_sp = stack_alloc.allocate( stack_allocator::default_stacksize() );
         uc.uc_stack.ss_size = stack_allocator::default_stacksize();
         ::makecontext( & uc, fn, 7);
- 
-        boost::uint64_t res = measure_time().count();
-        std::cout << "average of " << res << " nano seconds" << std::endl;
+
+        report r("ucontext", json, csv);
+        r.add( "ucontext_t", "ns", measure_time() );
 #ifdef BOOST_CONTEXT_CYCLE
-        res = measure_cycles();
-        std::cout << "average of " << res << " cpu cycles" << std::endl;
+        r.add( "ucontext_t", "cycles", measure_cycles() );
 #endif
+        r.write();
 
         return EXIT_SUCCESS;
     }
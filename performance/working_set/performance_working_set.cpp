@@ -0,0 +1,197 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/context/all.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/program_options.hpp>
+
+#include "../bind_processor.hpp"
+#include "../clock.hpp"
+#include "../stats.hpp"
+
+namespace ctx = boost::context;
+
+std::vector< std::size_t > contexts = { 1000, 10000, 100000, 1000000 };
+// rounds over all contexts
+boost::uint64_t runs = 20;
+// one page per context: each context touches its own page
+std::size_t stack_size = 4096;
+
+// carves the stacks out of one contiguous block so that millions of
+// contexts fit into memory; stacks are released with the pool
+class pool {
+private:
+    char            *   base_;
+    std::size_t         size_;
+    std::size_t         count_;
+    std::size_t         used_;
+
+public:
+    pool( std::size_t size, std::size_t count) :
+        base_( nullptr),
+        size_( size),
+        count_( count),
+        used_( 0) {
+        // stack tops are page aligned
+        base_ = static_cast< char * >( std::malloc( size_ * count_ + 4096) );
+        if ( nullptr == base_) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~pool() {
+        std::free( base_);
+    }
+
+    pool( pool const&) = delete;
+    pool & operator=( pool const&) = delete;
+
+    ctx::stack_context allocate() {
+        if ( count_ == used_) {
+            throw std::bad_alloc();
+        }
+        char * top = base_ + 4096 - reinterpret_cast< std::uintptr_t >( base_) % 4096 + ++used_ * size_;
+        ctx::stack_context sctx;
+        sctx.size = size_;
+        sctx.sp = top;
+        return sctx;
+    }
+};
+
+struct pool_stack {
+    pool    *   p;
+
+    ctx::stack_context allocate() {
+        return p->allocate();
+    }
+
+    void deallocate( ctx::stack_context &) {
+    }
+};
+
+// resumes the contexts in the order of `order` (each resumption is a round
+// trip, i.e. two context switches); one sample per round
+std::vector< double > measure( std::vector< ctx::execution_context > & v, std::vector< std::size_t > const& order) {
+    std::vector< double > samples;
+    samples.reserve( runs);
+    const duration_type overhead = overhead_clock();
+    // warm-up: the first round faults in the stacks
+    for ( std::size_t i : order) {
+        v[i]();
+    }
+    for ( boost::uint64_t r = 0; r < runs; ++r) {
+        time_point_type start( clock_type::now() );
+        for ( std::size_t i : order) {
+            v[i]();
+        }
+        duration_type total = clock_type::now() - start;
+        total -= overhead; // overhead of measurement
+        samples.push_back( static_cast< double >( total.count() ) / ( 2 * order.size() ) );
+    }
+    return samples;
+}
+
+void run( report & r, std::size_t n) {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    std::vector< ctx::execution_context > v;
+    v.reserve( n);
+#if defined(BOOST_USE_SEGMENTED_STACKS)
+    // execution_context accepts only segmented_stack if segmented stacks are enabled
+    ctx::segmented_stack salloc;
+#else
+    pool p( stack_size, n);
+    pool_stack salloc = { & p };
+#endif
+    for ( std::size_t i = 0; i < n; ++i) {
+        v.emplace_back(
+            std::allocator_arg, salloc,
+            [&mctx]( void *) {
+                while ( true) {
+                    mctx();
+                }
+            });
+    }
+    std::map< std::string, double > extra;
+    extra["contexts"] = static_cast< double >( n);
+    extra["stack_size"] = static_cast< double >( stack_size);
+
+    std::vector< std::size_t > order( n);
+    std::iota( order.begin(), order.end(), 0);
+    r.add( "round-robin, " + std::to_string( n) + " contexts", "ns", measure( v, order), extra);
+
+    std::mt19937_64 rng( 42);
+    std::shuffle( order.begin(), order.end(), rng);
+    r.add( "random, " + std::to_string( n) + " contexts", "ns", measure( v, order), extra);
+    // contexts are destroyed before the pool
+    v.clear();
+}
+
+int main( int argc, char * argv[])
+{
+    try
+    {
+        std::string json, csv;
+
+        bind_to_processor( 0);
+
+        boost::program_options::options_description desc("allowed options");
+        desc.add_options()
+            ("help", "help message")
+            ("contexts,c", boost::program_options::value< std::vector< std::size_t > >( & contexts)->multitoken(), "number of contexts")
+            ("runs,r", boost::program_options::value< boost::uint64_t >( & runs), "rounds over all contexts (samples)")
+            ("size,s", boost::program_options::value< std::size_t >( & stack_size), "stack size (multiple of the page size)")
+            ("json", boost::program_options::value< std::string >( & json), "write results as JSON ('-' for stdout)")
+            ("csv", boost::program_options::value< std::string >( & csv), "write results as CSV ('-' for stdout)");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(
+                boost::program_options::parse_command_line(
+                    argc,
+                    argv,
+                    desc),
+                vm);
+        boost::program_options::notify( vm);
+
+        if ( vm.count("help") ) {
+            std::cout << desc << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if ( 0 == runs) {
+            throw std::invalid_argument("runs must not be zero");
+        }
+        if ( 0 == stack_size || 0 != stack_size % 4096) {
+            throw std::invalid_argument("stack size must be a multiple of 4096");
+        }
+
+        report r("working_set", json, csv);
+        for ( std::size_t n : contexts) {
+            if ( 0 < n) {
+                run( r, n);
+            }
+        }
+        r.write();
+
+        return EXIT_SUCCESS;
+    }
+    catch ( std::exception const& e)
+    { std::cerr << "exception: " << e.what() << std::endl; }
+    catch (...)
+    { std::cerr << "unhandled exception" << std::endl; }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/accounting.hpp"
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/accounting.hpp>
+#include <boost/context/detail/config.hpp>
+
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING) && ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+# include <algorithm>
+# include <mutex>
+# include <utility>
+
+# include <boost/context/execution_context.hpp>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING) && ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+namespace detail {
+
+thread_local
+std::uint64_t
+accounting_hook::last_switch_ = 0;
+
+std::chrono::nanoseconds ticks_to_ns( std::uint64_t t) noexcept {
+    return std::chrono::nanoseconds(
+            static_cast< std::chrono::nanoseconds::rep >( static_cast< double >( t) * ns_per_tick() ) );
+}
+
+}
+
+std::vector< context_usage > top_contexts( std::size_t n) {
+    typedef std::pair< std::uint64_t, context_usage >   entry_t;
+
+    std::vector< entry_t > entries;
+    detail::context_list * l = detail::context_list::current();
+    if ( nullptr != l) {
+        detail::activation_record const* running = detail::activation_record::current_rec.get();
+        std::unique_lock< detail::spinlock > lk( l->mtx);
+        for ( detail::registry_hook const* h = l->head; nullptr != h; h = h->next) {
+            detail::activation_record const* ar = static_cast< detail::activation_record const* >( h);
+            context_usage u;
+            u.id = ar;
+            u.name = ar->name;
+            u.cpu_time = std::chrono::nanoseconds::zero();
+            u.resumes = ar->resumes.load( std::memory_order_relaxed);
+            entries.push_back( entry_t( detail::run_ticks( ar, running == ar), u) );
+        }
+    }
+    n = ( std::min)( n, entries.size() );
+    std::partial_sort( entries.begin(), entries.begin() + n, entries.end(),
+                       []( entry_t const& a, entry_t const& b) {
+                            return a.first > b.first;
+                       });
+    std::vector< context_usage > result;
+    for ( std::size_t i = 0; i < n; ++i) {
+        entries[i].second.cpu_time = detail::ticks_to_ns( entries[i].first);
+        result.push_back( entries[i].second);
+    }
+    return result;
+}
+#else
+std::vector< context_usage > top_contexts( std::size_t) {
+    return std::vector< context_usage >();
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,107 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/channel.hpp"
+
+# include <algorithm>
+# include <functional>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+namespace {
+
+// `order` is sorted by channel, a channel is locked once
+void lock_all( select_case ** order, std::size_t n) noexcept {
+    for ( std::size_t i = 0; i < n; ++i) {
+        if ( 0 == i || order[i - 1]->channel() != order[i]->channel() ) {
+            order[i]->lock();
+        }
+    }
+}
+
+void unlock_all( select_case ** order, std::size_t n) noexcept {
+    for ( std::size_t i = n; 0 < i; --i) {
+        if ( 1 == i || order[i - 2]->channel() != order[i - 1]->channel() ) {
+            order[i - 1]->unlock();
+        }
+    }
+}
+
+bool expire( void * vp) noexcept {
+    // claimed with a marker that matches none of the cases
+    std::atomic< waiter * > * selected = static_cast< std::atomic< waiter * > * >( vp);
+    waiter * expected = nullptr;
+    return selected->compare_exchange_strong(
+            expected, reinterpret_cast< waiter * >( selected), std::memory_order_acq_rel);
+}
+
+}
+
+select_result select_( select_case ** cases, select_case ** order, std::size_t n,
+                       std::chrono::steady_clock::time_point deadline) {
+    // all channels stay locked while the cases are tested and enqueued,
+    // the waiters can not be claimed before all of them are enqueued
+    std::copy( cases, cases + n, order);
+    std::sort( order, order + n,
+               []( select_case const* l, select_case const* r) {
+                    return std::less< void const* >()( l->channel(), r->channel() );
+               });
+    lock_all( order, n);
+    for ( std::size_t i = 0; i < n; ++i) {
+        channel_op_status status;
+        waiter * wake = nullptr;
+        if ( cases[i]->try_locked( status, wake) ) {
+            unlock_all( order, n);
+            if ( nullptr != wake) {
+                wait_queue::wake( wake);
+            }
+            return select_result{ i, status };
+        }
+    }
+    if ( std::chrono::steady_clock::now() >= deadline) {
+        unlock_all( order, n);
+        return select_result{ n, channel_op_status::timeout };
+    }
+    std::atomic< waiter * > selected( nullptr);
+    for ( std::size_t i = 0; i < n; ++i) {
+        cases[i]->enqueue_locked( & selected);
+    }
+    unlock_all( order, n);
+    // resumed by the party that claimed `selected`
+    wait_queue::park( deadline, & expire, & selected);
+    lock_all( order, n);
+    for ( std::size_t i = 0; i < n; ++i) {
+        cases[i]->dequeue_locked();
+    }
+    unlock_all( order, n);
+    waiter const* w = selected.load( std::memory_order_acquire);
+    for ( std::size_t i = 0; i < n; ++i) {
+        if ( cases[i]->node() == w) {
+            return select_result{ i, cases[i]->status() };
+        }
+    }
+    return select_result{ n, channel_op_status::timeout };
+}
+
+}}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
@@ -0,0 +1,45 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/detail/clock.hpp"
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+namespace {
+
+// the TSC is compared against steady_clock over 10ms
+double calibrate() noexcept {
+    if ( ! ticks_are_tsc) {
+        return 1.;
+    }
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    const std::uint64_t c0 = ticks();
+    std::chrono::steady_clock::time_point t1;
+    do {
+        t1 = std::chrono::steady_clock::now();
+    } while ( t1 - t0 < std::chrono::milliseconds( 10) );
+    const std::uint64_t c1 = ticks();
+    return std::chrono::duration< double, std::nano >( t1 - t0).count() / static_cast< double >( c1 - c0);
+}
+
+}
+
+double ns_per_tick() noexcept {
+    // calibrated once
+    static const double ns = calibrate();
+    return ns;
+}
+
+}}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
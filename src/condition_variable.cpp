@@ -0,0 +1,73 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/condition_variable.hpp"
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+condition_variable::condition_variable() noexcept :
+    splk_(),
+    waiters_() {
+}
+
+condition_variable::~condition_variable() {
+    BOOST_ASSERT( waiters_.empty() );
+}
+
+bool
+condition_variable::wait_( std::unique_lock< mutex > & lk, std::chrono::steady_clock::time_point deadline) noexcept {
+    BOOST_ASSERT( lk.owns_lock() );
+    detail::waiter w;
+    splk_.lock();
+    // enqueued before the mutex is released, a notification
+    // issued after unlock() can not be lost
+    waiters_.push_back( & w);
+    lk.unlock();
+    const bool ok = detail::wait_queue::suspend( & splk_, w, deadline);
+    lk.lock();
+    return ok;
+}
+
+void
+condition_variable::notify_one() noexcept {
+    detail::waiter * w;
+    {
+        std::unique_lock< detail::spinlock > lk( splk_);
+        w = waiters_.pop_front();
+    }
+    if ( nullptr != w) {
+        detail::wait_queue::wake( w);
+    }
+}
+
+void
+condition_variable::notify_all() noexcept {
+    detail::waiter * w;
+    {
+        std::unique_lock< detail::spinlock > lk( splk_);
+        w = waiters_.pop_all();
+    }
+    detail::wait_queue::wake_all( w);
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
@@ -10,6 +10,9 @@
 
 # include "boost/context/execution_context.hpp"
 
+# include <atomic>
+# include <stdexcept>
+
 # include <boost/config.hpp>
 
 # ifdef BOOST_HAS_ABI_HEADERS
@@ -27,19 +30,54 @@ detail::activation_record::current_rec;
 // zero-initialization
 thread_local static std::size_t counter;
 
+// keeps the record of the main context alive while other contexts run;
+// current_rec drops its reference at the first switch
+thread_local static activation_record::ptr_t main_rec;
+
 // schwarz counter
 activation_record_initializer::activation_record_initializer() {
     if ( 0 == counter++) {
-        activation_record::current_rec.reset( new activation_record() );
+        main_rec.reset( new activation_record() );
+        activation_record::current_rec = main_rec;
     }
 }
 
 activation_record_initializer::~activation_record_initializer() {
     if ( 0 == --counter) {
         activation_record::current_rec.reset();
+        main_rec.reset();
     }
 }
 
+namespace {
+
+std::atomic< std::size_t >      fls_count( 0);
+std::atomic< fls_cleanup_t >    fls_cleanups[BOOST_CONTEXT_FLS_SLOTS];
+
+}
+
+std::size_t fls_register( fls_cleanup_t cleanup) {
+    BOOST_ASSERT( nullptr != cleanup);
+    std::size_t idx = fls_count.load( std::memory_order_relaxed);
+    do {
+        if ( BOOST_CONTEXT_FLS_SLOTS <= idx) {
+            throw std::length_error("boost::context: no free fiber-local storage slot");
+        }
+    } while ( ! fls_count.compare_exchange_weak( idx, idx + 1, std::memory_order_relaxed) );
+    // a value can not be stored before the index was returned
+    fls_cleanups[idx].store( cleanup, std::memory_order_release);
+    return idx;
+}
+
+fls_cleanup_t fls_cleanup( std::size_t idx) noexcept {
+    BOOST_ASSERT( idx < BOOST_CONTEXT_FLS_SLOTS);
+    return fls_cleanups[idx].load( std::memory_order_acquire);
+}
+
+std::size_t fls_slots() noexcept {
+    return fls_count.load( std::memory_order_relaxed);
+}
+
 }
 
 execution_context
@@ -0,0 +1,355 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/histogram.hpp"
+
+#include <cstdio>
+#include <ostream>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/clock.hpp>
+
+#if defined(BOOST_CONTEXT_USE_HISTOGRAMS)
+# include <mutex>
+# include <new>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+namespace {
+
+const double percentiles[] = { 50., 90., 99., 99.9, 99.99, 100. };
+
+std::uint64_t mid( std::size_t i) noexcept {
+    const std::uint64_t lo = detail::histogram_lower( i);
+    return lo + ( detail::histogram_upper( i) - lo) / 2;
+}
+
+// the buckets of the highest power of two exceed nanoseconds::max()
+std::chrono::nanoseconds to_ns( std::uint64_t v) noexcept {
+    const std::uint64_t max = static_cast< std::uint64_t >( ( std::chrono::nanoseconds::max)().count() );
+    return std::chrono::nanoseconds( static_cast< std::chrono::nanoseconds::rep >( v < max ? v : max) );
+}
+
+}
+
+constexpr std::size_t latency_histogram::buckets;
+
+latency_histogram::latency_histogram() noexcept :
+    total_( 0),
+    counts_() {
+}
+
+void
+latency_histogram::record( std::chrono::nanoseconds d, std::uint64_t n) noexcept {
+    const std::uint64_t v = 0 < d.count() ? static_cast< std::uint64_t >( d.count() ) : 0;
+    counts_[detail::histogram_bucket( v)] += n;
+    total_ += n;
+}
+
+latency_histogram &
+latency_histogram::operator+=( latency_histogram const& other) noexcept {
+    for ( std::size_t i = 0; i < buckets; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    return * this;
+}
+
+void
+latency_histogram::clear() noexcept {
+    for ( std::uint64_t & c : counts_) {
+        c = 0;
+    }
+    total_ = 0;
+}
+
+std::chrono::nanoseconds
+latency_histogram::lower_bound( std::size_t bucket) noexcept {
+    return to_ns( detail::histogram_lower( bucket) );
+}
+
+std::chrono::nanoseconds
+latency_histogram::upper_bound( std::size_t bucket) noexcept {
+    return to_ns( detail::histogram_upper( bucket) );
+}
+
+std::chrono::nanoseconds
+latency_histogram::min() const noexcept {
+    for ( std::size_t i = 0; i < buckets; ++i) {
+        if ( 0 != counts_[i]) {
+            return lower_bound( i);
+        }
+    }
+    return std::chrono::nanoseconds::zero();
+}
+
+std::chrono::nanoseconds
+latency_histogram::max() const noexcept {
+    for ( std::size_t i = buckets; 0 < i--; ) {
+        if ( 0 != counts_[i]) {
+            return upper_bound( i);
+        }
+    }
+    return std::chrono::nanoseconds::zero();
+}
+
+std::chrono::nanoseconds
+latency_histogram::mean() const noexcept {
+    if ( 0 == total_) {
+        return std::chrono::nanoseconds::zero();
+    }
+    double sum = 0.;
+    for ( std::size_t i = 0; i < buckets; ++i) {
+        if ( 0 != counts_[i]) {
+            sum += static_cast< double >( mid( i) ) * static_cast< double >( counts_[i]);
+        }
+    }
+    return std::chrono::nanoseconds(
+            static_cast< std::chrono::nanoseconds::rep >( sum / static_cast< double >( total_) ) );
+}
+
+std::chrono::nanoseconds
+latency_histogram::percentile( double p) const noexcept {
+    if ( 0 == total_) {
+        return std::chrono::nanoseconds::zero();
+    }
+    p = p < 0. ? 0. : ( 100. < p ? 100. : p);
+    // rank of the value, at least the first one
+    std::uint64_t rank = static_cast< std::uint64_t >( p / 100. * static_cast< double >( total_) + .5);
+    if ( 0 == rank) {
+        rank = 1;
+    }
+    std::uint64_t seen = 0;
+    for ( std::size_t i = 0; i < buckets; ++i) {
+        seen += counts_[i];
+        if ( rank <= seen) {
+            return upper_bound( i);
+        }
+    }
+    return max();
+}
+
+void
+latency_histogram::write_text( std::ostream & os) const {
+    char buf[64];
+    os << "count " << total_;
+    std::snprintf( buf, sizeof( buf), " min %.3fus mean %.3fus max %.3fus\n",
+                   static_cast< double >( min().count() ) / 1000.,
+                   static_cast< double >( mean().count() ) / 1000.,
+                   static_cast< double >( max().count() ) / 1000.);
+    os << buf;
+    for ( double p : percentiles) {
+        std::snprintf( buf, sizeof( buf), "  p%-6g %12.3fus\n",
+                       p, static_cast< double >( percentile( p).count() ) / 1000.);
+        os << buf;
+    }
+}
+
+void
+latency_histogram::write_json( std::ostream & os) const {
+    os << "{\"count\":" << total_
+       << ",\"min_ns\":" << min().count()
+       << ",\"mean_ns\":" << mean().count()
+       << ",\"max_ns\":" << max().count()
+       << ",\"percentiles\":{";
+    char buf[32];
+    bool first = true;
+    for ( double p : percentiles) {
+        std::snprintf( buf, sizeof( buf), "\"%g\":", p);
+        os << ( first ? "" : ",") << buf << percentile( p).count();
+        first = false;
+    }
+    os << "},\"buckets\":[";
+    first = true;
+    for ( std::size_t i = 0; i < buckets; ++i) {
+        if ( 0 != counts_[i]) {
+            os << ( first ? "" : ",")
+               << "[" << lower_bound( i).count() << "," << upper_bound( i).count() << "," << counts_[i] << "]";
+            first = false;
+        }
+    }
+    os << "]}";
+}
+
+void write_text( std::ostream & os, switch_histograms const& h) {
+    os << "run slice: ";
+    h.run_slice.write_text( os);
+    os << "suspended: ";
+    h.suspended.write_text( os);
+}
+
+void write_json( std::ostream & os, switch_histograms const& h) {
+    os << "{\"run_slice\":";
+    h.run_slice.write_json( os);
+    os << ",\"suspended\":";
+    h.suspended.write_json( os);
+    os << "}";
+}
+
+#if defined(BOOST_CONTEXT_USE_HISTOGRAMS)
+namespace detail {
+
+namespace {
+
+// all blocks ever allocated; blocks are never freed
+std::mutex              blocks_mtx;
+histogram_block     *   blocks = nullptr;
+// counts in ticks of terminated threads
+std::uint64_t           retired_run_slice[histogram_buckets] = {};
+std::uint64_t           retired_suspended[histogram_buckets] = {};
+// used by a thread after its block was released (thread-local
+// destructors running after the registrar)
+histogram_block         orphan;
+thread_local bool       exited = false;
+
+// the buckets count ticks, their midpoints are converted to nanoseconds
+void convert( std::uint64_t const* ticks, latency_histogram & h) noexcept {
+    const double ns = ns_per_tick();
+    for ( std::size_t i = 0; i < histogram_buckets; ++i) {
+        if ( 0 != ticks[i]) {
+            h.record( std::chrono::nanoseconds(
+                        static_cast< std::chrono::nanoseconds::rep >( static_cast< double >( mid( i) ) * ns) ),
+                      ticks[i]);
+        }
+    }
+}
+
+void collect( histogram_block const& b, std::uint64_t * run_slice, std::uint64_t * suspended) noexcept {
+    for ( std::size_t i = 0; i < histogram_buckets; ++i) {
+        run_slice[i] += b.run_slice[i].load( std::memory_order_relaxed);
+        suspended[i] += b.suspended[i].load( std::memory_order_relaxed);
+    }
+}
+
+void reset( histogram_block & b) noexcept {
+    for ( std::size_t i = 0; i < histogram_buckets; ++i) {
+        b.run_slice[i].store( 0, std::memory_order_relaxed);
+        b.suspended[i].store( 0, std::memory_order_relaxed);
+    }
+}
+
+switch_histograms snapshot( std::uint64_t const* run_slice, std::uint64_t const* suspended) {
+    switch_histograms h;
+    convert( run_slice, h.run_slice);
+    convert( suspended, h.suspended);
+    return h;
+}
+
+// releases the block of the thread at thread exit
+struct registrar {
+    ~registrar() {
+        histogram_block * b = histogram_block::current_;
+        std::unique_lock< std::mutex > lk( blocks_mtx);
+        collect( * b, retired_run_slice, retired_suspended);
+        reset( * b);
+        b->last_switch = 0;
+        b->in_use = false;
+        histogram_block::current_ = nullptr;
+        exited = true;
+    }
+};
+
+}
+
+thread_local
+histogram_block *
+histogram_block::current_ = nullptr;
+
+histogram_block *
+histogram_block::attach() noexcept {
+    if ( exited) {
+        return & orphan;
+    }
+    histogram_block * b = nullptr;
+    {
+        std::unique_lock< std::mutex > lk( blocks_mtx);
+        for ( histogram_block * i = blocks; nullptr != i; i = i->nxt) {
+            if ( ! i->in_use) {
+                b = i;
+                break;
+            }
+        }
+        if ( nullptr == b) {
+            b = new ( std::nothrow) histogram_block();
+            if ( nullptr == b) {
+                return & orphan;
+            }
+            b->nxt = blocks;
+            blocks = b;
+        }
+        b->in_use = true;
+    }
+    current_ = b;
+    // destroyed at thread exit
+    thread_local static registrar r;
+    return b;
+}
+
+}
+
+switch_histograms thread_histograms() {
+    std::uint64_t run_slice[detail::histogram_buckets] = {};
+    std::uint64_t suspended[detail::histogram_buckets] = {};
+    detail::collect( detail::histogram_block::current(), run_slice, suspended);
+    return detail::snapshot( run_slice, suspended);
+}
+
+switch_histograms aggregate_histograms() {
+    std::uint64_t run_slice[detail::histogram_buckets] = {};
+    std::uint64_t suspended[detail::histogram_buckets] = {};
+    {
+        std::unique_lock< std::mutex > lk( detail::blocks_mtx);
+        for ( std::size_t i = 0; i < detail::histogram_buckets; ++i) {
+            run_slice[i] = detail::retired_run_slice[i];
+            suspended[i] = detail::retired_suspended[i];
+        }
+        for ( detail::histogram_block * i = detail::blocks; nullptr != i; i = i->nxt) {
+            if ( i->in_use) {
+                detail::collect( * i, run_slice, suspended);
+            }
+        }
+        detail::collect( detail::orphan, run_slice, suspended);
+    }
+    return detail::snapshot( run_slice, suspended);
+}
+
+void reset_histograms() noexcept {
+    std::unique_lock< std::mutex > lk( detail::blocks_mtx);
+    for ( std::size_t i = 0; i < detail::histogram_buckets; ++i) {
+        detail::retired_run_slice[i] = 0;
+        detail::retired_suspended[i] = 0;
+    }
+    // the counters of running threads are written concurrently, increments
+    // overlapping the reset might be lost
+    for ( detail::histogram_block * i = detail::blocks; nullptr != i; i = i->nxt) {
+        detail::reset( * i);
+    }
+    detail::reset( detail::orphan);
+}
+#else
+switch_histograms thread_histograms() {
+    return switch_histograms();
+}
+
+switch_histograms aggregate_histograms() {
+    return switch_histograms();
+}
+
+void reset_histograms() noexcept {
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
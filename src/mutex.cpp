@@ -0,0 +1,83 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/mutex.hpp"
+
+# include <mutex>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+mutex::mutex() noexcept :
+    splk_(),
+    locked_( false),
+    waiters_() {
+}
+
+mutex::~mutex() {
+    BOOST_ASSERT( ! locked_);
+    BOOST_ASSERT( waiters_.empty() );
+}
+
+bool
+mutex::lock_( std::chrono::steady_clock::time_point deadline) noexcept {
+    // yields before the ownership is taken
+    detail::wait_queue::checkpoint();
+    splk_.lock();
+    if ( ! locked_) {
+        locked_ = true;
+        splk_.unlock();
+        return true;
+    }
+    detail::waiter w;
+    waiters_.push_back( & w);
+    // on wake-up the ownership has been handed over by unlock()
+    return detail::wait_queue::suspend( & splk_, w, deadline);
+}
+
+bool
+mutex::try_lock() noexcept {
+    std::unique_lock< detail::spinlock > lk( splk_);
+    if ( locked_) {
+        return false;
+    }
+    locked_ = true;
+    return true;
+}
+
+void
+mutex::unlock() noexcept {
+    detail::waiter * w;
+    {
+        std::unique_lock< detail::spinlock > lk( splk_);
+        BOOST_ASSERT( locked_);
+        w = waiters_.pop_front();
+        if ( nullptr == w) {
+            locked_ = false;
+            return;
+        }
+        // direct hand-off: `locked_` stays set, newcomers can not barge in
+    }
+    detail::wait_queue::wake( w);
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
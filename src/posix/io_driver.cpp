@@ -0,0 +1,611 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/io_driver.hpp"
+
+extern "C" {
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if defined(__linux__)
+# include <linux/io_uring.h>
+# include <sys/eventfd.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+#endif
+}
+
+# include <algorithm>
+# include <cerrno>
+# include <condition_variable>
+# include <cstring>
+# include <deque>
+# include <mutex>
+# include <system_error>
+# include <thread>
+# include <vector>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+class io_backend {
+public:
+    virtual ~io_backend() {}
+
+    // queue request; submitted with the next call of poll() or wait()
+    // returns false if the request failed immediately, its result is set
+    // to the negative errno then
+    virtual bool enqueue( io_driver &, io_op *) = 0;
+
+    virtual void poll( io_driver &) = 0;
+
+    virtual void wait( io_driver &, scheduler::clock_type::time_point) = 0;
+
+    // interrupt wait(); called from other threads
+    virtual void notify() noexcept = 0;
+};
+
+}
+
+namespace {
+
+# if defined(__linux__)
+class uring_backend : public detail::io_backend {
+private:
+    int                 fd_;
+    unsigned int        features_;
+    unsigned int        sq_entries_;
+    void            *   sq_ptr_;
+    std::size_t         sq_len_;
+    void            *   cq_ptr_;
+    std::size_t         cq_len_;
+    unsigned int    *   sq_head_;
+    unsigned int    *   sq_tail_;
+    unsigned int    *   sq_mask_;
+    unsigned int    *   sq_array_;
+    unsigned int    *   cq_head_;
+    unsigned int    *   cq_tail_;
+    unsigned int    *   cq_mask_;
+    io_uring_sqe    *   sqes_;
+    io_uring_cqe    *   cqes_;
+    unsigned int        to_submit_;
+    __kernel_timespec   ts_;
+    // notify() writes to the eventfd, a read request is kept armed
+    int                 efd_;
+    eventfd_t           ebuf_;
+    bool                armed_;
+
+    // user_data of the read request of the eventfd
+    BOOST_STATIC_CONSTEXPR __u64 notify_tag = 1;
+
+    void close_() noexcept {
+        if ( nullptr != sqes_) {
+            ::munmap( sqes_, sq_entries_ * sizeof( io_uring_sqe) );
+        }
+        if ( nullptr != cq_ptr_ && cq_ptr_ != sq_ptr_) {
+            ::munmap( cq_ptr_, cq_len_);
+        }
+        if ( nullptr != sq_ptr_) {
+            ::munmap( sq_ptr_, sq_len_);
+        }
+        ::close( fd_);
+        if ( -1 != efd_) {
+            ::close( efd_);
+        }
+    }
+
+    int enter_( unsigned int min_complete, unsigned int flags, void * arg, std::size_t argsz) noexcept {
+        for (;;) {
+            const long ret = ::syscall( __NR_io_uring_enter, fd_, to_submit_, min_complete, flags, arg, argsz);
+            if ( 0 <= ret) {
+                to_submit_ -= static_cast< unsigned int >( ret);
+                return 0;
+            }
+            if ( EINTR != errno) {
+                // ETIME: deadline reached
+                // EAGAIN/EBUSY: completion queue is full, reap first
+                return errno;
+            }
+        }
+    }
+
+    void reap_( io_driver & drv) noexcept {
+        unsigned int head = * cq_head_;
+        const unsigned int tail = __atomic_load_n( cq_tail_, __ATOMIC_ACQUIRE);
+        while ( head != tail) {
+            io_uring_cqe * cqe = & cqes_[head & * cq_mask_];
+            // timeout requests carry no operation
+            detail::io_op * op = reinterpret_cast< detail::io_op * >( cqe->user_data);
+            if ( notify_tag == cqe->user_data) {
+                armed_ = false;
+            } else if ( nullptr != op) {
+                op->result = cqe->res;
+                drv.complete( op);
+            }
+            ++head;
+        }
+        __atomic_store_n( cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+    // returns nullptr with errno set if the submission queue stays full
+    io_uring_sqe * get_sqe_( io_driver & drv) noexcept {
+        unsigned int tail = * sq_tail_;
+        while ( tail - __atomic_load_n( sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            // submission queue full, hand over what we have
+            const int err = enter_( 0, 0, nullptr, 0);
+            if ( EBUSY == err || EAGAIN == err) {
+                // completion queue overflowed, the kernel accepts new
+                // submissions after the completions have been reaped
+                reap_( drv);
+            } else if ( 0 != err) {
+                errno = err;
+                return nullptr;
+            }
+        }
+        const unsigned int idx = tail & * sq_mask_;
+        io_uring_sqe * sqe = & sqes_[idx];
+        std::memset( sqe, 0, sizeof( io_uring_sqe) );
+        sq_array_[idx] = idx;
+        return sqe;
+    }
+
+    void push_sqe_() noexcept {
+        __atomic_store_n( sq_tail_, * sq_tail_ + 1, __ATOMIC_RELEASE);
+        ++to_submit_;
+    }
+
+    void arm_( io_driver & drv) noexcept {
+        if ( armed_) {
+            return;
+        }
+        io_uring_sqe * sqe = get_sqe_( drv);
+        if ( nullptr == sqe) {
+            // wait() is not interrupted by notify(), armed again next time
+            return;
+        }
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = efd_;
+        sqe->addr = reinterpret_cast< __u64 >( & ebuf_);
+        sqe->len = sizeof( ebuf_);
+        sqe->user_data = notify_tag;
+        push_sqe_();
+        armed_ = true;
+    }
+
+public:
+    explicit uring_backend( unsigned int entries) :
+        fd_( -1),
+        features_( 0),
+        sq_entries_( 0),
+        sq_ptr_( nullptr),
+        sq_len_( 0),
+        cq_ptr_( nullptr),
+        cq_len_( 0),
+        sq_head_( nullptr),
+        sq_tail_( nullptr),
+        sq_mask_( nullptr),
+        sq_array_( nullptr),
+        cq_head_( nullptr),
+        cq_tail_( nullptr),
+        cq_mask_( nullptr),
+        sqes_( nullptr),
+        cqes_( nullptr),
+        to_submit_( 0),
+        ts_(),
+        efd_( -1),
+        ebuf_( 0),
+        armed_( false) {
+        io_uring_params p;
+        std::memset( & p, 0, sizeof( p) );
+        fd_ = static_cast< int >( ::syscall( __NR_io_uring_setup, entries, & p) );
+        if ( 0 > fd_) {
+            throw std::system_error( errno, std::system_category(), "io_uring_setup() failed");
+        }
+        // IORING_OP_READ/IORING_OP_WRITE require linux 5.6 and later; there
+        // is no feature flag for them, IORING_FEAT_FAST_POLL (linux 5.7) is
+        // the closest one
+        if ( 0 == ( p.features & IORING_FEAT_FAST_POLL) ) {
+            ::close( fd_);
+            throw std::system_error( ENOSYS, std::system_category(), "io_uring too old");
+        }
+        features_ = p.features;
+        sq_entries_ = p.sq_entries;
+        sq_len_ = p.sq_off.array + p.sq_entries * sizeof( unsigned int);
+        cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof( io_uring_cqe);
+        if ( 0 != ( p.features & IORING_FEAT_SINGLE_MMAP) ) {
+            sq_len_ = cq_len_ = ( std::max)( sq_len_, cq_len_);
+        }
+        void * vp = ::mmap( 0, sq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if ( MAP_FAILED == vp) {
+            const int err = errno;
+            close_();
+            throw std::system_error( err, std::system_category(), "mmap() of submission queue failed");
+        }
+        sq_ptr_ = vp;
+        if ( 0 != ( p.features & IORING_FEAT_SINGLE_MMAP) ) {
+            cq_ptr_ = sq_ptr_;
+        } else {
+            vp = ::mmap( 0, cq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+            if ( MAP_FAILED == vp) {
+                const int err = errno;
+                close_();
+                throw std::system_error( err, std::system_category(), "mmap() of completion queue failed");
+            }
+            cq_ptr_ = vp;
+        }
+        vp = ::mmap( 0, p.sq_entries * sizeof( io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if ( MAP_FAILED == vp) {
+            const int err = errno;
+            close_();
+            throw std::system_error( err, std::system_category(), "mmap() of submission entries failed");
+        }
+        sqes_ = static_cast< io_uring_sqe * >( vp);
+        char * sq = static_cast< char * >( sq_ptr_);
+        sq_head_ = reinterpret_cast< unsigned int * >( sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast< unsigned int * >( sq + p.sq_off.tail);
+        sq_mask_ = reinterpret_cast< unsigned int * >( sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast< unsigned int * >( sq + p.sq_off.array);
+        char * cq = static_cast< char * >( cq_ptr_);
+        cq_head_ = reinterpret_cast< unsigned int * >( cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast< unsigned int * >( cq + p.cq_off.tail);
+        cq_mask_ = reinterpret_cast< unsigned int * >( cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast< io_uring_cqe * >( cq + p.cq_off.cqes);
+        efd_ = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if ( -1 == efd_) {
+            const int err = errno;
+            close_();
+            throw std::system_error( err, std::system_category(), "eventfd() failed");
+        }
+    }
+
+    ~uring_backend() {
+        close_();
+    }
+
+    bool enqueue( io_driver & drv, detail::io_op * op) override {
+        io_uring_sqe * sqe = get_sqe_( drv);
+        if ( nullptr == sqe) {
+            op->result = -errno;
+            return false;
+        }
+        sqe->fd = op->fd;
+        sqe->user_data = reinterpret_cast< __u64 >( op);
+        switch ( op->code) {
+        case detail::io_op::code_read:
+            sqe->opcode = IORING_OP_READ;
+            sqe->addr = reinterpret_cast< __u64 >( op->buf);
+            sqe->len = static_cast< __u32 >( op->len);
+            sqe->off = static_cast< __u64 >( op->offset);
+            break;
+        case detail::io_op::code_write:
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->addr = reinterpret_cast< __u64 >( op->buf);
+            sqe->len = static_cast< __u32 >( op->len);
+            sqe->off = static_cast< __u64 >( op->offset);
+            break;
+        case detail::io_op::code_accept:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->addr = reinterpret_cast< __u64 >( op->buf);
+            sqe->addr2 = reinterpret_cast< __u64 >( op->addrlen);
+            break;
+        case detail::io_op::code_fsync:
+            sqe->opcode = IORING_OP_FSYNC;
+            break;
+        }
+        push_sqe_();
+        return true;
+    }
+
+    void poll( io_driver & drv) override {
+        if ( 0 < to_submit_) {
+            enter_( 0, 0, nullptr, 0);
+        }
+        reap_( drv);
+    }
+
+    void wait( io_driver & drv, scheduler::clock_type::time_point deadline) override {
+        arm_( drv);
+        if ( scheduler::clock_type::time_point::max() == deadline) {
+            enter_( 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        } else {
+            const std::chrono::nanoseconds rel = ( std::max)(
+                    std::chrono::nanoseconds::zero(),
+                    std::chrono::duration_cast< std::chrono::nanoseconds >( deadline - scheduler::clock_type::now() ) );
+            ts_.tv_sec = std::chrono::duration_cast< std::chrono::seconds >( rel).count();
+            ts_.tv_nsec = ( rel - std::chrono::seconds( ts_.tv_sec) ).count();
+#  if defined(IORING_FEAT_EXT_ARG)
+            if ( 0 != ( features_ & IORING_FEAT_EXT_ARG) ) {
+                io_uring_getevents_arg arg;
+                std::memset( & arg, 0, sizeof( arg) );
+                arg.ts = reinterpret_cast< __u64 >( & ts_);
+                enter_( 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, & arg, sizeof( arg) );
+                reap_( drv);
+                return;
+            }
+#  endif
+            // older kernels: bound the wait by a timeout request
+            io_uring_sqe * sqe = get_sqe_( drv);
+            if ( nullptr == sqe) {
+                // the wait could not be bounded, the scheduler calls again
+                reap_( drv);
+                return;
+            }
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->fd = -1;
+            sqe->addr = reinterpret_cast< __u64 >( & ts_);
+            sqe->len = 1;
+            sqe->user_data = 0;
+            push_sqe_();
+            enter_( 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        }
+        reap_( drv);
+    }
+
+    void notify() noexcept override {
+        ::eventfd_write( efd_, 1);
+    }
+};
+# endif
+
+class thread_pool_backend : public detail::io_backend {
+private:
+    std::mutex                          mtx_;
+    std::condition_variable             work_cond_;
+    std::condition_variable             done_cond_;
+    std::vector< detail::io_op * >      pending_;
+    std::deque< detail::io_op * >       queue_;
+    std::vector< detail::io_op * >      completed_;
+    std::vector< detail::io_op * >      reaped_;
+    std::vector< std::thread >          workers_;
+    bool                                shutdown_;
+    bool                                notified_;
+
+    static void execute_( detail::io_op * op) noexcept {
+        long res = -1;
+        switch ( op->code) {
+        case detail::io_op::code_read:
+            res = 0 > op->offset
+                ? ::read( op->fd, op->buf, op->len)
+                : ::pread( op->fd, op->buf, op->len, op->offset);
+            break;
+        case detail::io_op::code_write:
+            res = 0 > op->offset
+                ? ::write( op->fd, op->buf, op->len)
+                : ::pwrite( op->fd, op->buf, op->len, op->offset);
+            break;
+        case detail::io_op::code_accept:
+            res = ::accept( op->fd, static_cast< sockaddr * >( op->buf), op->addrlen);
+            break;
+        case detail::io_op::code_fsync:
+            res = ::fsync( op->fd);
+            break;
+        }
+        op->result = 0 > res ? -errno : res;
+    }
+
+    void worker_() noexcept {
+        std::unique_lock< std::mutex > lk( mtx_);
+        for (;;) {
+            work_cond_.wait( lk, [this](){ return shutdown_ || ! queue_.empty(); });
+            if ( queue_.empty() ) {
+                return;
+            }
+            detail::io_op * op = queue_.front();
+            queue_.pop_front();
+            lk.unlock();
+            execute_( op);
+            lk.lock();
+            completed_.push_back( op);
+            done_cond_.notify_one();
+        }
+    }
+
+    void flush_() {
+        if ( pending_.empty() ) {
+            return;
+        }
+        {
+            std::unique_lock< std::mutex > lk( mtx_);
+            queue_.insert( queue_.end(), pending_.begin(), pending_.end() );
+        }
+        if ( 1 == pending_.size() ) {
+            work_cond_.notify_one();
+        } else {
+            work_cond_.notify_all();
+        }
+        pending_.clear();
+    }
+
+    void reap_( io_driver & drv) noexcept {
+        for ( detail::io_op * op : reaped_) {
+            drv.complete( op);
+        }
+        reaped_.clear();
+    }
+
+public:
+    explicit thread_pool_backend( std::size_t threads) :
+        shutdown_( false),
+        notified_( false) {
+        BOOST_ASSERT( 0 < threads);
+        workers_.reserve( threads);
+        for ( std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back( & thread_pool_backend::worker_, this);
+        }
+    }
+
+    ~thread_pool_backend() {
+        {
+            std::unique_lock< std::mutex > lk( mtx_);
+            shutdown_ = true;
+        }
+        work_cond_.notify_all();
+        for ( std::thread & t : workers_) {
+            t.join();
+        }
+    }
+
+    bool enqueue( io_driver &, detail::io_op * op) override {
+        pending_.push_back( op);
+        return true;
+    }
+
+    void poll( io_driver & drv) override {
+        flush_();
+        {
+            std::unique_lock< std::mutex > lk( mtx_);
+            reaped_.swap( completed_);
+        }
+        reap_( drv);
+    }
+
+    void wait( io_driver & drv, scheduler::clock_type::time_point deadline) override {
+        flush_();
+        {
+            std::unique_lock< std::mutex > lk( mtx_);
+            if ( scheduler::clock_type::time_point::max() == deadline) {
+                done_cond_.wait( lk, [this](){ return notified_ || ! completed_.empty(); });
+            } else {
+                done_cond_.wait_until( lk, deadline, [this](){ return notified_ || ! completed_.empty(); });
+            }
+            notified_ = false;
+            reaped_.swap( completed_);
+        }
+        reap_( drv);
+    }
+
+    void notify() noexcept override {
+        std::unique_lock< std::mutex > lk( mtx_);
+        notified_ = true;
+        done_cond_.notify_one();
+    }
+};
+
+template< typename T >
+T io_result( long res) noexcept {
+    if ( 0 > res) {
+        errno = static_cast< int >( -res);
+        return -1;
+    }
+    return static_cast< T >( res);
+}
+
+}
+
+io_driver::io_driver( scheduler & sched, backend_t backend, unsigned int entries, std::size_t threads) :
+    sched_( sched),
+    impl_(),
+    backend_( backend),
+    inflight_( 0) {
+# if defined(__linux__)
+    if ( backend_thread_pool != backend) {
+        try {
+            impl_.reset( new uring_backend( entries) );
+            backend_ = backend_io_uring;
+        } catch ( std::system_error const&) {
+            if ( backend_io_uring == backend) {
+                throw;
+            }
+        }
+    }
+# else
+    (void)entries;
+    if ( backend_io_uring == backend) {
+        throw std::system_error( ENOSYS, std::system_category(), "io_uring not supported");
+    }
+# endif
+    if ( ! impl_) {
+        impl_.reset( new thread_pool_backend( threads) );
+        backend_ = backend_thread_pool;
+    }
+    sched_.attach( this);
+}
+
+io_driver::~io_driver() {
+    BOOST_ASSERT( 0 == inflight_);
+    sched_.detach( this);
+}
+
+long
+io_driver::submit_( detail::io_op & op) noexcept {
+    BOOST_ASSERT( sched_.running() );
+    op.task = sched_.running();
+    op.result = 0;
+    if ( ! impl_->enqueue( * this, & op) ) {
+        // failed before submission, never in flight
+        return op.result;
+    }
+    ++inflight_;
+    // resumed by complete(); not a cancellation point, the request
+    // references `op` on this stack until it completes
+    sched_.suspend_();
+    return op.result;
+}
+
+ssize_t
+io_driver::read( int fd, void * buf, std::size_t len, off_t offset) noexcept {
+    detail::io_op op = { detail::io_op::code_read, fd, buf, len, offset, nullptr, task_handle(), 0 };
+    return io_result< ssize_t >( submit_( op) );
+}
+
+ssize_t
+io_driver::write( int fd, void const* buf, std::size_t len, off_t offset) noexcept {
+    detail::io_op op = { detail::io_op::code_write, fd, const_cast< void * >( buf), len, offset, nullptr, task_handle(), 0 };
+    return io_result< ssize_t >( submit_( op) );
+}
+
+int
+io_driver::accept( int fd, sockaddr * addr, socklen_t * addrlen) noexcept {
+    detail::io_op op = { detail::io_op::code_accept, fd, addr, 0, 0, addrlen, task_handle(), 0 };
+    return io_result< int >( submit_( op) );
+}
+
+int
+io_driver::fsync( int fd) noexcept {
+    detail::io_op op = { detail::io_op::code_fsync, fd, nullptr, 0, 0, nullptr, task_handle(), 0 };
+    return io_result< int >( submit_( op) );
+}
+
+void
+io_driver::poll() {
+    impl_->poll( * this);
+}
+
+void
+io_driver::wait( scheduler::clock_type::time_point deadline) {
+    impl_->wait( * this, deadline);
+}
+
+void
+io_driver::notify() noexcept {
+    impl_->notify();
+}
+
+void
+io_driver::complete( detail::io_op * op) noexcept {
+    BOOST_ASSERT( 0 < inflight_);
+    --inflight_;
+    sched_.ready( op->task);
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
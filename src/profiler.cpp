@@ -0,0 +1,367 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/profiler.hpp"
+
+#include <ostream>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+
+#if defined(BOOST_CONTEXT_USE_PROFILER) && ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT) && \
+    defined(__linux__) && defined(__x86_64__) && ! defined(__ILP32__)
+# define BOOST_CONTEXT_PROFILER
+
+extern "C" {
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+}
+
+# include <atomic>
+# include <cstdint>
+# include <cstdio>
+# include <map>
+# include <mutex>
+# include <new>
+# include <string>
+# include <system_error>
+# include <vector>
+
+# include <boost/context/execution_context.hpp>
+# include <boost/context/detail/symbolize.hpp>
+
+// samples per thread, further samples are dropped
+# if ! defined(BOOST_CONTEXT_PROFILE_SAMPLES)
+#  define BOOST_CONTEXT_PROFILE_SAMPLES 4096
+# endif
+// frames per sample
+# if ! defined(BOOST_CONTEXT_PROFILE_FRAMES)
+#  define BOOST_CONTEXT_PROFILE_FRAMES 32
+# endif
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+#if defined(BOOST_CONTEXT_PROFILER)
+namespace detail {
+
+namespace {
+
+struct sample {
+    char const*     name;
+    std::size_t     depth;
+    // frames[0] is the interrupted instruction, return addresses follow
+    void        *   frames[BOOST_CONTEXT_PROFILE_FRAMES];
+};
+
+// written only by the signal handler on the owning thread
+struct profile_buffer {
+    // samples [base, count) are valid; a slot is written only while
+    // count - base < BOOST_CONTEXT_PROFILE_SAMPLES
+    std::atomic< std::size_t >  count;
+    std::atomic< std::size_t >  base;
+    std::atomic< std::size_t >  dropped;
+    // extent of the thread stack, used while the main context runs
+    std::uintptr_t              stack_lo;
+    std::uintptr_t              stack_hi;
+    timer_t                     timer;
+    bool                        armed;
+    // buffers are never freed; new buffers are pushed at the front
+    profile_buffer          *   nxt;
+    bool                        in_use;
+    sample                      samples[BOOST_CONTEXT_PROFILE_SAMPLES];
+
+    profile_buffer() noexcept :
+        count( 0),
+        base( 0),
+        dropped( 0),
+        stack_lo( 0),
+        stack_hi( 0),
+        timer(),
+        armed( false),
+        nxt( nullptr),
+        in_use( false) {
+    }
+};
+
+std::mutex                          buffers_mtx;
+std::atomic< profile_buffer * >     buffers( nullptr);
+std::once_flag                      handler_flag;
+// a pointer, the signal handler does not trigger the initialization of the
+// thread-local storage
+thread_local profile_buffer     *   current_buffer = nullptr;
+thread_local bool                   exited = false;
+
+// runs on the interrupted stack; async-signal-safe
+void record( profile_buffer * b, ucontext_t const* uc) noexcept {
+    const std::size_t n = b->count.load( std::memory_order_relaxed);
+    if ( BOOST_CONTEXT_PROFILE_SAMPLES <= n - b->base.load( std::memory_order_acquire) ) {
+        b->dropped.store( b->dropped.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    sample & s = b->samples[n % BOOST_CONTEXT_PROFILE_SAMPLES];
+    s.frames[0] = reinterpret_cast< void * >( uc->uc_mcontext.gregs[REG_RIP]);
+    s.depth = 1;
+    // the initialization of current_rec was forced by profiler_start()
+    activation_record const* ar = activation_record::current_rec.get();
+    std::uintptr_t lo = b->stack_lo, hi = b->stack_hi;
+    if ( nullptr == ar) {
+        s.name = "[thread]";
+    } else if ( 0 != ar->sctx.size) {
+        s.name = nullptr != ar->name ? ar->name : "[unnamed]";
+        hi = reinterpret_cast< std::uintptr_t >( ar->sctx.sp);
+        lo = hi - ar->sctx.size;
+    } else {
+        s.name = nullptr != ar->name ? ar->name : "[main]";
+    }
+    // inside jump_fcontext() the stack pointer might still point to the
+    // stack of the previous context, the walk is skipped
+    const std::uintptr_t sp = static_cast< std::uintptr_t >( uc->uc_mcontext.gregs[REG_RSP]);
+    if ( sp < lo || hi <= sp) {
+        lo = hi;
+    } else {
+        lo = sp;
+    }
+    std::uintptr_t rbp = static_cast< std::uintptr_t >( uc->uc_mcontext.gregs[REG_RBP]);
+    while ( s.depth < BOOST_CONTEXT_PROFILE_FRAMES &&
+            lo <= rbp && rbp + 2 * sizeof( void *) <= hi &&
+            0 == ( rbp & ( sizeof( void *) - 1) ) ) {
+        void * ret = reinterpret_cast< void * const* >( rbp)[1];
+        if ( nullptr == ret) {
+            break;
+        }
+        s.frames[s.depth++] = ret;
+        lo = rbp + 2 * sizeof( void *);
+        rbp = reinterpret_cast< std::uintptr_t const* >( rbp)[0];
+    }
+    b->count.store( n + 1, std::memory_order_release);
+}
+
+void on_sigprof( int, siginfo_t *, void * uc) {
+    const int err = errno;
+    profile_buffer * b = current_buffer;
+    if ( nullptr != b) {
+        record( b, static_cast< ucontext_t const* >( uc) );
+    }
+    errno = err;
+}
+
+void disarm( profile_buffer * b) noexcept {
+    if ( b->armed) {
+        ::timer_delete( b->timer);
+        b->armed = false;
+    }
+}
+
+// stops the timer of the thread at thread exit; the samples are kept until
+// profiler_clear()
+struct registrar {
+    ~registrar() {
+        disarm( current_buffer);
+        std::unique_lock< std::mutex > lk( buffers_mtx);
+        current_buffer->in_use = false;
+        current_buffer = nullptr;
+        exited = true;
+    }
+};
+
+profile_buffer * attach() {
+    profile_buffer * b = nullptr;
+    {
+        std::unique_lock< std::mutex > lk( buffers_mtx);
+        for ( profile_buffer * i = buffers.load( std::memory_order_relaxed); nullptr != i; i = i->nxt) {
+            if ( ! i->in_use &&
+                 i->count.load( std::memory_order_relaxed) == i->base.load( std::memory_order_relaxed) ) {
+                b = i;
+                break;
+            }
+        }
+        if ( nullptr == b) {
+            b = new profile_buffer();
+            b->nxt = buffers.load( std::memory_order_relaxed);
+            buffers.store( b, std::memory_order_release);
+        }
+        b->in_use = true;
+    }
+    pthread_attr_t attr;
+    if ( 0 == ::pthread_getattr_np( ::pthread_self(), & attr) ) {
+        void * addr = nullptr;
+        std::size_t size = 0;
+        if ( 0 == ::pthread_attr_getstack( & attr, & addr, & size) ) {
+            b->stack_lo = reinterpret_cast< std::uintptr_t >( addr);
+            b->stack_hi = b->stack_lo + size;
+        }
+        ::pthread_attr_destroy( & attr);
+    }
+    current_buffer = b;
+    // destroyed at thread exit
+    thread_local static registrar r;
+    return b;
+}
+
+void install_handler() {
+    struct sigaction sa;
+    sa.sa_sigaction = on_sigprof;
+    ::sigemptyset( & sa.sa_mask);
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    if ( 0 != ::sigaction( SIGPROF, & sa, nullptr) ) {
+        throw std::system_error( errno, std::system_category(), "boost::context: sigaction() failed");
+    }
+}
+
+}
+
+}
+
+bool profiler_start( std::chrono::microseconds interval) {
+    if ( detail::exited) {
+        return false;
+    }
+    std::call_once( detail::handler_flag, detail::install_handler);
+    // the signal handler must not run the initialization of the thread-local
+    // storage of the library
+    execution_context::current();
+    detail::profile_buffer * b = detail::current_buffer;
+    if ( nullptr == b) {
+        b = detail::attach();
+    }
+    if ( ! b->armed) {
+        sigevent sev;
+        sev.sigev_notify = SIGEV_THREAD_ID;
+        sev.sigev_signo = SIGPROF;
+        sev.sigev_value.sival_ptr = nullptr;
+# if defined(sigev_notify_thread_id)
+        sev.sigev_notify_thread_id = static_cast< pid_t >( ::syscall( SYS_gettid) );
+# else
+        sev._sigev_un._tid = static_cast< pid_t >( ::syscall( SYS_gettid) );
+# endif
+        if ( 0 != ::timer_create( CLOCK_THREAD_CPUTIME_ID, & sev, & b->timer) ) {
+            throw std::system_error( errno, std::system_category(), "boost::context: timer_create() failed");
+        }
+        b->armed = true;
+    }
+    itimerspec its;
+    its.it_interval.tv_sec = static_cast< time_t >( interval.count() / 1000000);
+    its.it_interval.tv_nsec = static_cast< long >( interval.count() % 1000000) * 1000;
+    its.it_value = its.it_interval;
+    if ( 0 != ::timer_settime( b->timer, 0, & its, nullptr) ) {
+        const int err = errno;
+        detail::disarm( b);
+        throw std::system_error( err, std::system_category(), "boost::context: timer_settime() failed");
+    }
+    return true;
+}
+
+void profiler_stop() noexcept {
+    if ( nullptr != detail::current_buffer) {
+        detail::disarm( detail::current_buffer);
+    }
+}
+
+void profiler_clear() noexcept {
+    std::unique_lock< std::mutex > lk( detail::buffers_mtx);
+    for ( detail::profile_buffer * b = detail::buffers.load( std::memory_order_relaxed); nullptr != b; b = b->nxt) {
+        b->base.store( b->count.load( std::memory_order_acquire), std::memory_order_release);
+        b->dropped.store( 0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t profiler_samples() noexcept {
+    std::size_t n = 0;
+    for ( detail::profile_buffer * b = detail::buffers.load( std::memory_order_acquire); nullptr != b; b = b->nxt) {
+        n += b->count.load( std::memory_order_acquire) - b->base.load( std::memory_order_relaxed);
+    }
+    return n;
+}
+
+std::size_t profiler_dropped() noexcept {
+    std::size_t n = 0;
+    for ( detail::profile_buffer * b = detail::buffers.load( std::memory_order_acquire); nullptr != b; b = b->nxt) {
+        n += b->dropped.load( std::memory_order_relaxed);
+    }
+    return n;
+}
+
+void write_profile( std::ostream & os) {
+    std::map< std::string, std::size_t > stacks;
+    std::map< void *, std::string > names;
+    // the lock keeps profiler_clear() from releasing the slots being read
+    std::unique_lock< std::mutex > lk( detail::buffers_mtx);
+    for ( detail::profile_buffer * b = detail::buffers.load( std::memory_order_relaxed); nullptr != b; b = b->nxt) {
+        const std::size_t count = b->count.load( std::memory_order_acquire);
+        for ( std::size_t i = b->base.load( std::memory_order_relaxed); i < count; ++i) {
+            detail::sample const& s = b->samples[i % BOOST_CONTEXT_PROFILE_SAMPLES];
+            std::string stack( s.name);
+            for ( std::size_t j = s.depth; 0 < j--; ) {
+                std::map< void *, std::string >::iterator k = names.find( s.frames[j]);
+                if ( names.end() == k) {
+                    detail::symbol sym;
+                    std::string name;
+                    if ( detail::symbolize( s.frames[j], 0 != j, sym) && ! sym.name.empty() ) {
+                        name = sym.name;
+                    } else {
+                        char buf[32];
+                        std::snprintf( buf, sizeof( buf), "%p", s.frames[j]);
+                        name = buf;
+                    }
+                    // ';' separates the frames of collapsed stacks
+                    for ( char & c : name) {
+                        if ( ';' == c) {
+                            c = ':';
+                        }
+                    }
+                    k = names.insert( std::make_pair( s.frames[j], name) ).first;
+                }
+                stack += ';';
+                stack += k->second;
+            }
+            ++stacks[stack];
+        }
+    }
+    lk.unlock();
+    for ( std::pair< const std::string, std::size_t > const& e : stacks) {
+        os << e.first << ' ' << e.second << '\n';
+    }
+    os.flush();
+}
+#else
+bool profiler_start( std::chrono::microseconds) {
+    return false;
+}
+
+void profiler_stop() noexcept {
+}
+
+void profiler_clear() noexcept {
+}
+
+std::size_t profiler_samples() noexcept {
+    return 0;
+}
+
+std::size_t profiler_dropped() noexcept {
+    return 0;
+}
+
+void write_profile( std::ostream &) {
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,238 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/registry.hpp"
+
+#include <ostream>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/config.hpp>
+#include <boost/context/detail/registry.hpp>
+
+#if defined(BOOST_CONTEXT_USE_REGISTRY) && ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+# include <cstdint>
+# include <cstdio>
+# include <mutex>
+# include <new>
+
+# include <boost/context/execution_context.hpp>
+# include <boost/context/detail/symbolize.hpp>
+
+// layout of the context-data stored by jump_fcontext()
+# if defined(__x86_64__) && ! defined(__ILP32__) && ! defined(BOOST_WINDOWS) && ! defined(BOOST_USE_WINFIBERS)
+#  define BOOST_CONTEXT_FRAME_WALK
+#  define BOOST_CONTEXT_FCTX_RBP 0x30
+#  define BOOST_CONTEXT_FCTX_RIP 0x38
+#  define BOOST_CONTEXT_FCTX_SIZE 0x40
+# endif
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+#if defined(BOOST_CONTEXT_USE_REGISTRY) && ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+namespace detail {
+
+namespace {
+
+// all lists ever allocated; lists are never freed
+std::mutex                          lists_mtx;
+std::atomic< context_list * >       lists( nullptr);
+thread_local bool                   exited = false;
+
+// releases the list of the thread at thread exit; records still alive
+// remain linked until they are destroyed
+struct registrar {
+    ~registrar() {
+        std::unique_lock< std::mutex > lk( lists_mtx);
+        context_list::current_->in_use = false;
+        context_list::current_ = nullptr;
+        exited = true;
+    }
+};
+
+# if defined(BOOST_CONTEXT_FRAME_WALK)
+// follows the frame-pointer chain saved on the stack of a suspended
+// context; every read stays inside the stack of the context
+void walk( activation_record const* ar, std::size_t max_frames, std::vector< void * > & frames) {
+    const std::uintptr_t fctx = reinterpret_cast< std::uintptr_t >( ar->fctx);
+    if ( 0 == fctx || 0 == max_frames) {
+        return;
+    }
+    // return address into activation_record::resume()
+    frames.push_back( * reinterpret_cast< void * const* >( fctx + BOOST_CONTEXT_FCTX_RIP) );
+    // the extent of the stack of the main context is unknown
+    const std::uintptr_t top = reinterpret_cast< std::uintptr_t >( ar->sctx.sp);
+    if ( 0 == ar->sctx.size || top <= fctx) {
+        return;
+    }
+    std::uintptr_t lo = fctx + BOOST_CONTEXT_FCTX_SIZE;
+    std::uintptr_t rbp = * reinterpret_cast< std::uintptr_t const* >( fctx + BOOST_CONTEXT_FCTX_RBP);
+    while ( frames.size() < max_frames &&
+            lo <= rbp && rbp + 2 * sizeof( void *) <= top &&
+            0 == ( rbp & ( sizeof( void *) - 1) ) ) {
+        void * ret = reinterpret_cast< void * const* >( rbp)[1];
+        if ( nullptr == ret) {
+            break;
+        }
+        frames.push_back( ret);
+        lo = rbp + 2 * sizeof( void *);
+        rbp = reinterpret_cast< std::uintptr_t const* >( rbp)[0];
+    }
+}
+# endif
+
+void write_frame( std::ostream & os, std::size_t i, void * addr) {
+    char buf[32];
+    std::snprintf( buf, sizeof( buf), "%p", addr);
+    os << "  #" << i << " " << buf;
+    symbol sym;
+    if ( symbolize( addr, true, sym) ) {
+        if ( ! sym.name.empty() ) {
+            std::snprintf( buf, sizeof( buf), "+0x%lx", static_cast< unsigned long >( sym.offset) );
+            os << " in " << sym.name << buf;
+        }
+        if ( nullptr != sym.module) {
+            os << " (" << sym.module << ")";
+        }
+    }
+    os << "\n";
+}
+
+}
+
+thread_local
+context_list *
+context_list::current_ = nullptr;
+
+registry_hook::registry_hook( bool running_) noexcept :
+    prev( nullptr),
+    next( nullptr),
+    owner( context_list::current() ),
+    running( running_) {
+    if ( nullptr != owner) {
+        std::unique_lock< spinlock > lk( owner->mtx);
+        next = owner->head;
+        if ( nullptr != next) {
+            next->prev = this;
+        }
+        owner->head = this;
+    }
+}
+
+registry_hook::~registry_hook() {
+    if ( nullptr != owner) {
+        // might be destroyed by another thread than the creating one
+        std::unique_lock< spinlock > lk( owner->mtx);
+        if ( nullptr != prev) {
+            prev->next = next;
+        } else {
+            owner->head = next;
+        }
+        if ( nullptr != next) {
+            next->prev = prev;
+        }
+    }
+}
+
+context_list *
+context_list::attach() noexcept {
+    // records created by thread-local destructors running after the registrar
+    if ( exited) {
+        return nullptr;
+    }
+    context_list * l = nullptr;
+    {
+        std::unique_lock< std::mutex > lk( lists_mtx);
+        for ( context_list * i = lists.load( std::memory_order_relaxed); nullptr != i; i = i->nxt) {
+            if ( ! i->in_use) {
+                std::unique_lock< spinlock > ilk( i->mtx);
+                if ( nullptr == i->head) {
+                    l = i;
+                    break;
+                }
+            }
+        }
+        if ( nullptr == l) {
+            l = new ( std::nothrow) context_list();
+            if ( nullptr == l) {
+                return nullptr;
+            }
+            l->nxt = lists.load( std::memory_order_relaxed);
+            lists.store( l, std::memory_order_release);
+        }
+        l->in_use = true;
+    }
+    current_ = l;
+    // destroyed at thread exit
+    thread_local static registrar r;
+    return l;
+}
+
+context_list *
+context_list::first() noexcept {
+    return lists.load( std::memory_order_acquire);
+}
+
+}
+
+std::vector< context_backtrace > context_backtraces( std::size_t max_frames) {
+    std::vector< context_backtrace > result;
+    for ( detail::context_list * l = detail::context_list::first(); nullptr != l; l = l->nxt) {
+        // blocks the destruction of the records, their stacks remain mapped
+        std::unique_lock< detail::spinlock > lk( l->mtx);
+        for ( detail::registry_hook const* h = l->head; nullptr != h; h = h->next) {
+            detail::activation_record const* ar = static_cast< detail::activation_record const* >( h);
+            context_backtrace bt;
+            bt.id = ar;
+            bt.name = ar->name;
+            bt.running = h->running.load( std::memory_order_relaxed);
+# if defined(BOOST_CONTEXT_FRAME_WALK)
+            if ( ! bt.running) {
+                detail::walk( ar, max_frames, bt.frames);
+            }
+# endif
+            result.push_back( bt);
+        }
+    }
+    return result;
+}
+
+void write_backtraces( std::ostream & os, std::size_t max_frames) {
+    // symbolized outside of the locks
+    const std::vector< context_backtrace > bts = context_backtraces( max_frames);
+    for ( context_backtrace const& bt : bts) {
+        char buf[32];
+        std::snprintf( buf, sizeof( buf), "%p", bt.id);
+        os << "context " << buf;
+        if ( nullptr != bt.name) {
+            os << " \"" << bt.name << "\"";
+        }
+        os << ( bt.running ? " (running)\n" : " (suspended)\n");
+        for ( std::size_t i = 0; i < bt.frames.size(); ++i) {
+            detail::write_frame( os, i, bt.frames[i]);
+        }
+    }
+    os.flush();
+}
+#else
+std::vector< context_backtrace > context_backtraces( std::size_t) {
+    return std::vector< context_backtrace >();
+}
+
+void write_backtraces( std::ostream &, std::size_t) {
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
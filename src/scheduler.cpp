@@ -0,0 +1,716 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/scheduler.hpp"
+
+# include <condition_variable>
+# include <cstdlib>
+# include <limits>
+# include <mutex>
+# include <thread>
+# include <utility>
+# include <vector>
+
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+namespace detail {
+
+namespace {
+
+// index of the highest set bit, `v` != 0
+unsigned int highest( unsigned int v) noexcept {
+#if defined(__GNUC__)
+    return 31 - static_cast< unsigned int >( __builtin_clz( v) );
+#else
+    unsigned int i = 0;
+    while ( 0 != ( v >>= 1) ) {
+        ++i;
+    }
+    return i;
+#endif
+}
+
+// index of the lowest set bit, `v` != 0
+unsigned int lowest( unsigned int v) noexcept {
+#if defined(__GNUC__)
+    return static_cast< unsigned int >( __builtin_ctz( v) );
+#else
+    unsigned int i = 0;
+    while ( 0 == ( v & 1) ) {
+        v >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+std::size_t rank( task_record * t) noexcept {
+    return nullptr != t ? t->rank : 0;
+}
+
+// earliest deadline first, arrival breaks ties
+bool before( task_record * l, task_record * r) noexcept {
+    return l->attrs.deadline < r->attrs.deadline ||
+           ( l->attrs.deadline == r->attrs.deadline && l->seq < r->seq);
+}
+
+// merges two leftist heaps; recurses along the right spines, which are
+// at most log(n) long
+task_record * merge( task_record * l, task_record * r) noexcept {
+    if ( nullptr == l) {
+        return r;
+    }
+    if ( nullptr == r) {
+        return l;
+    }
+    if ( before( r, l) ) {
+        std::swap( l, r);
+    }
+    l->right = merge( l->right, r);
+    if ( rank( l->left) < rank( l->right) ) {
+        std::swap( l->left, l->right);
+    }
+    l->rank = rank( l->right) + 1;
+    return l;
+}
+
+}
+
+// requests a yield from contexts running longer than the time slice of
+// their scheduler; one thread serves all schedulers, it samples the
+// resumption counters (no time stamps on the switch path), a slice is
+// noticed within half a slice
+class watchdog {
+private:
+    struct entry {
+        scheduler                       *   sched;
+        scheduler::clock_type::duration     slice;
+        std::uint64_t                       seen;
+        scheduler::clock_type::time_point   since;
+    };
+
+    std::mutex                  mtx_;
+    std::condition_variable     cnd_;
+    std::vector< entry >        entries_;
+
+    watchdog() :
+        mtx_(),
+        cnd_(),
+        entries_() {
+        // never joined, the watchdog lives until the process exits
+        std::thread( & watchdog::run_, this).detach();
+    }
+
+    void run_() {
+        std::unique_lock< std::mutex > lk( mtx_);
+        while ( true) {
+            if ( entries_.empty() ) {
+                cnd_.wait( lk);
+                continue;
+            }
+            const scheduler::clock_type::time_point now = scheduler::clock_type::now();
+            scheduler::clock_type::duration tick = entries_.front().slice;
+            for ( entry & e : entries_) {
+                const std::uint64_t r = e.sched->resumptions_.load( std::memory_order_relaxed);
+                if ( r != e.seen) {
+                    e.seen = r;
+                    e.since = now;
+                } else if ( 0 != ( r & 1) && e.slice <= now - e.since) {
+                    e.sched->preempt_.store( true, std::memory_order_relaxed);
+                }
+                if ( e.slice < tick) {
+                    tick = e.slice;
+                }
+            }
+            cnd_.wait_for( lk, tick / 2);
+        }
+    }
+
+public:
+    static watchdog & instance() {
+        // never destroyed, schedulers might outlive static objects
+        static watchdog * w = new watchdog();
+        return * w;
+    }
+
+    void set( scheduler * sched, scheduler::clock_type::duration slice) {
+        std::unique_lock< std::mutex > lk( mtx_);
+        for ( std::vector< entry >::iterator i = entries_.begin(); i != entries_.end(); ++i) {
+            if ( sched == i->sched) {
+                entries_.erase( i);
+                break;
+            }
+        }
+        if ( scheduler::clock_type::duration::zero() < slice) {
+            entry e = { sched, slice, sched->resumptions_.load( std::memory_order_relaxed),
+                        scheduler::clock_type::now() };
+            entries_.push_back( e);
+        }
+        cnd_.notify_one();
+    }
+};
+
+}
+
+constexpr unsigned int scheduler::max_priority;
+
+thread_local
+scheduler *
+scheduler::current_ = nullptr;
+
+scheduler *
+scheduler::current() noexcept {
+    return current_;
+}
+
+scheduler::scheduler( clock_type::duration resolution) :
+    // contexts return to the thread constructing the scheduler
+    dispatcher_( execution_context::current() ),
+    running_( nullptr),
+    ready_heads_(),
+    ready_tails_(),
+    ready_mask_( 0),
+    ready_edf_( nullptr),
+    ready_count_( 0),
+    ready_seq_( 0),
+    bypassed_( 0),
+    starvation_limit_( 16),
+    budget_( 0),
+    zombie_( nullptr),
+    tasks_( nullptr),
+    live_( 0),
+    poller_( nullptr),
+    wheel_(),
+    origin_( clock_type::now() ),
+    resolution_( resolution),
+    blocked_( 0),
+    remote_splk_(),
+    remote_head_( nullptr),
+    remote_tail_( & remote_head_),
+    idle_( false),
+    wake_( 0),
+    drained_( 0),
+    slice_( clock_type::duration::zero() ),
+    resumptions_( 0),
+    preempt_( false) {
+    BOOST_ASSERT( clock_type::duration::zero() < resolution_);
+    for ( unsigned int p = 0; p <= max_priority; ++p) {
+        ready_tails_[p] = & ready_heads_[p];
+    }
+}
+
+scheduler::~scheduler() {
+    if ( clock_type::duration::zero() != slice_) {
+        detail::watchdog::instance().set( this, clock_type::duration::zero() );
+    }
+    if ( 0 < live_) {
+        unwind_all_();
+    }
+    BOOST_ASSERT( 0 == live_);
+    BOOST_ASSERT( nullptr == running_);
+    BOOST_ASSERT( nullptr == zombie_);
+    BOOST_ASSERT( 0 == ready_count_);
+    BOOST_ASSERT( nullptr == remote_head_);
+}
+
+void
+scheduler::resume_( detail::task_record * t) noexcept {
+    running_ = t;
+    // a request of the watchdog refers to the previous context
+    preempt_.store( false, std::memory_order_relaxed);
+    resumptions_.store( resumptions_.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // returns once a context switched back to the dispatcher, not
+    // necessarily `t`
+    t->ctx.resume_();
+    resumptions_.store( resumptions_.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    running_ = nullptr;
+    reap_();
+}
+
+void
+scheduler::transfer_( detail::task_record * next) noexcept {
+    detail::task_record * self = running_;
+    if ( nullptr == next && 0 < budget_ && 0 < ready_count_) {
+        next = next_ready_();
+    }
+    if ( self == next) {
+        // yielded, but no other context is ready
+        preempt_.store( false, std::memory_order_relaxed);
+        return;
+    }
+    if ( nullptr == next) {
+        // the tick is exhausted, timers and the poller are due
+        dispatcher_.resume_();
+    } else {
+        running_ = next;
+        preempt_.store( false, std::memory_order_relaxed);
+        // stays odd, the watchdog observes a new resumption
+        resumptions_.store( resumptions_.load( std::memory_order_relaxed) + 2, std::memory_order_relaxed);
+        next->ctx.resume_();
+    }
+    // resumed by the dispatcher or directly by another context
+    BOOST_ASSERT( self == running_);
+    reap_();
+}
+
+void
+scheduler::reap_() noexcept {
+    if ( nullptr != zombie_) {
+        detail::task_record * t = zombie_;
+        zombie_ = nullptr;
+        destroy_( t);
+    }
+}
+
+void
+scheduler::enlist_( detail::task_record * t) noexcept {
+    t->live_nxt = tasks_;
+    if ( nullptr != tasks_) {
+        tasks_->live_prev = t;
+    }
+    tasks_ = t;
+    ++live_;
+}
+
+void
+scheduler::destroy_( detail::task_record * t) noexcept {
+    if ( nullptr != t->live_prev) {
+        t->live_prev->live_nxt = t->live_nxt;
+    } else {
+        tasks_ = t->live_nxt;
+    }
+    if ( nullptr != t->live_nxt) {
+        t->live_nxt->live_prev = t->live_prev;
+    }
+    // the last reference to the execution context releases the stack
+    // the task record lives on
+    execution_context ctx( std::move( t->ctx) );
+    t->~task_record();
+    --live_;
+}
+
+void
+scheduler::unwind_( detail::task_record * t) noexcept {
+    // forced_unwind is thrown at the suspension point of `t`; a context
+    // suspended in a primitive (not a cancellation point) continues until
+    // it reaches one
+    t->ctx.force_unwind_();
+    running_ = t;
+    t->ctx.resume_();
+    running_ = nullptr;
+    if ( zombie_ != t && t->ctx.finished_() ) {
+        // never entered its function, left without exit()
+        destroy_( t);
+    }
+    reap_();
+}
+
+void
+scheduler::unwind_all_() noexcept {
+    BOOST_ASSERT( nullptr == running_);
+    BOOST_ASSERT( execution_context::current() == dispatcher_);
+    scheduler * prev = current_;
+    current_ = this;
+    drain_remote_();
+    while ( 0 < live_) {
+        // contexts made ready by the unwinding (e.g. a context joining
+        // the unwound ones) are resumed first
+        if ( 0 < ready_count_) {
+            unwind_( pop_ready_() );
+            continue;
+        }
+        detail::task_record * t = tasks_;
+        while ( nullptr != t && t->ctx.forced_unwind_() ) {
+            t = t->live_nxt;
+        }
+        if ( nullptr == t) {
+            break;
+        }
+        unwind_( t);
+    }
+    // contexts catching forced_unwind without rethrowing it are released
+    // without unwinding their stacks
+    while ( nullptr != tasks_) {
+        if ( nullptr != tasks_->tmo) {
+            wheel_.cancel( tasks_->tmo);
+            tasks_->tmo = nullptr;
+        }
+        tasks_->ctx.finish_();
+        destroy_( tasks_);
+    }
+    current_ = prev;
+}
+
+void
+scheduler::run() {
+    scheduler * prev = current_;
+    current_ = this;
+    while ( 0 < live_) {
+        drain_remote_();
+        // a tick dispatches as many contexts as were ready at its
+        // beginning; contexts becoming ready during the tick compete
+        // according to their scheduling class; a suspending context
+        // resumes the next one directly, the dispatcher regains control
+        // once the tick is exhausted
+        budget_ = ready_count_;
+        while ( 0 < budget_ && 0 < ready_count_) {
+            resume_( next_ready_() );
+        }
+        budget_ = 0;
+        if ( nullptr != poller_) {
+            // requests issued during this tick are submitted as one batch
+            poller_->poll();
+        }
+        expire_timers_();
+        if ( 0 == ready_count_ && 0 < live_) {
+            const clock_type::time_point deadline = wheel_.empty()
+                ? clock_type::time_point::max()
+                : from_tick_( wheel_.next_expiry() );
+            if ( nullptr == poller_ || ! poller_->busy() ) {
+                if ( clock_type::time_point::max() == deadline && 0 == blocked_) {
+                    // all remaining contexts wait for each other
+                    break;
+                }
+            }
+            idle_wait_( deadline);
+        }
+    }
+    current_ = prev;
+}
+
+void
+scheduler::idle_wait_( clock_type::time_point deadline) noexcept {
+    std::int32_t epoch;
+    {
+        std::unique_lock< detail::spinlock > lk( remote_splk_);
+        if ( nullptr != remote_head_) {
+            return;
+        }
+        // ready_remote() wakes the dispatcher only if `idle_` is set
+        idle_ = true;
+        epoch = wake_.load( std::memory_order_relaxed);
+    }
+    if ( nullptr != poller_) {
+        poller_->wait( deadline);
+    } else {
+        detail::futex_wait( & wake_, epoch, deadline);
+    }
+    std::unique_lock< detail::spinlock > lk( remote_splk_);
+    idle_ = false;
+}
+
+void
+scheduler::yield() {
+    detail::activation_record::unwind_point();
+    yield_();
+    detail::activation_record::unwind_point();
+}
+
+void
+scheduler::yield_() noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    ready_( running_);
+    transfer_( nullptr);
+}
+
+void
+scheduler::attributes( task_attributes const& attrs) noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    BOOST_ASSERT( attrs.priority <= max_priority);
+    running_->attrs = attrs;
+}
+
+task_attributes
+scheduler::attributes() const noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    return running_->attrs;
+}
+
+void
+scheduler::suspend() {
+    detail::activation_record::unwind_point();
+    suspend_();
+    detail::activation_record::unwind_point();
+}
+
+void
+scheduler::suspend_() noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    transfer_( nullptr);
+}
+
+void
+scheduler::switch_to_( detail::task_record * t) {
+    BOOST_ASSERT( nullptr != running_);
+    detail::activation_record::unwind_point();
+    transfer_to_( t);
+    detail::activation_record::unwind_point();
+}
+
+void
+scheduler::transfer_to_( detail::task_record * t) noexcept {
+    BOOST_ASSERT( nullptr != t);
+    BOOST_ASSERT( running_ != t);
+    BOOST_ASSERT( ! t->ready);
+    if ( nullptr != t->tmo) {
+        wheel_.cancel( t->tmo);
+        t->tmo = nullptr;
+    }
+    transfer_( t);
+}
+
+void
+scheduler::yield_to( task_handle t) {
+    BOOST_ASSERT( nullptr != running_);
+    // checked once before the running context is queued, it must not be
+    // unwound while linked into the ready queue
+    detail::activation_record::unwind_point();
+    ready_( running_);
+    transfer_to_( t.task_);
+    detail::activation_record::unwind_point();
+}
+
+void
+scheduler::cancel( task_handle h) {
+    detail::task_record * t = h.task_;
+    BOOST_ASSERT( nullptr != t);
+    t->ctx.cancel_();
+    interrupt_( t);
+}
+
+void
+scheduler::interrupt_( detail::task_record * t) noexcept {
+    if ( t != running_ && nullptr != t->tmo) {
+        // the wait ends as if its deadline had been reached
+        detail::task_timer * tmr = t->tmo;
+        wheel_.cancel( tmr);
+        expire_( tmr);
+    }
+}
+
+void
+scheduler::time_slice( clock_type::duration slice) {
+    BOOST_ASSERT( clock_type::duration::zero() <= slice);
+    if ( clock_type::duration::zero() == slice && clock_type::duration::zero() == slice_) {
+        return;
+    }
+    slice_ = slice;
+    detail::watchdog::instance().set( this, slice);
+}
+
+bool
+scheduler::suspend_until( clock_type::time_point deadline, bool (* fn)( void *), void * vp) {
+    detail::activation_record::unwind_point();
+    const bool ok = suspend_until_( deadline, fn, vp);
+    detail::activation_record::unwind_point();
+    return ok;
+}
+
+bool
+scheduler::suspend_until_( clock_type::time_point deadline, bool (* fn)( void *), void * vp) noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    BOOST_ASSERT( nullptr == running_->tmo);
+    if ( clock_type::time_point::max() == deadline) {
+        transfer_( nullptr);
+        return true;
+    }
+    // timer lives on the stack of the suspended context
+    detail::task_timer tmr( running_, fn, vp);
+    running_->tmo = & tmr;
+    wheel_.insert( & tmr, to_tick_( deadline) );
+    transfer_( nullptr);
+    // ready() cancels the timer if the context is woken before expiry
+    return ! tmr.expired;
+}
+
+void
+scheduler::sleep_until( clock_type::time_point tp) {
+    suspend_until( tp);
+}
+
+void
+scheduler::ready_( detail::task_record * t) noexcept {
+    BOOST_ASSERT( nullptr != t);
+    if ( nullptr != t->tmo) {
+        wheel_.cancel( t->tmo);
+        t->tmo = nullptr;
+    }
+    push_ready_( t);
+}
+
+void
+scheduler::ready_remote_( detail::task_record * t) noexcept {
+    BOOST_ASSERT( nullptr != t);
+    // the scheduler might be destroyed as soon as `t` has been
+    // drained, it is not touched after releasing the lock
+    std::unique_lock< detail::spinlock > lk( remote_splk_);
+    BOOST_ASSERT( nullptr == t->nxt);
+    * remote_tail_ = t;
+    remote_tail_ = & t->nxt;
+    wake_.fetch_add( 1, std::memory_order_relaxed);
+    if ( idle_) {
+        if ( nullptr != poller_) {
+            poller_->notify();
+        } else {
+            detail::futex_wake( & wake_, 1);
+        }
+    }
+}
+
+void
+scheduler::drain_remote_() noexcept {
+    detail::task_record * t;
+    {
+        std::unique_lock< detail::spinlock > lk( remote_splk_);
+        t = remote_head_;
+        remote_head_ = nullptr;
+        remote_tail_ = & remote_head_;
+        drained_ = wake_.load( std::memory_order_relaxed);
+    }
+    while ( nullptr != t) {
+        detail::task_record * nxt = t->nxt;
+        t->nxt = nullptr;
+        ready_( t);
+        t = nxt;
+    }
+}
+
+void
+scheduler::push_ready_( detail::task_record * t) noexcept {
+    BOOST_ASSERT( nullptr == t->nxt);
+    BOOST_ASSERT( ! t->ready);
+    t->ready = true;
+    ++ready_count_;
+    if ( clock_type::time_point::max() != t->attrs.deadline) {
+        t->seq = ready_seq_++;
+        t->left = nullptr;
+        t->right = nullptr;
+        t->rank = 1;
+        ready_edf_ = detail::merge( ready_edf_, t);
+        return;
+    }
+    const unsigned int p = t->attrs.priority;
+    * ready_tails_[p] = t;
+    ready_tails_[p] = & t->nxt;
+    ready_mask_ |= 1u << p;
+}
+
+detail::task_record *
+scheduler::next_ready_() noexcept {
+    if ( wake_.load( std::memory_order_relaxed) != drained_) {
+        // a context of a higher class might have been made ready by another
+        // thread
+        drain_remote_();
+    }
+    --budget_;
+    return pop_ready_();
+}
+
+detail::task_record *
+scheduler::pop_ready_() noexcept {
+    BOOST_ASSERT( 0 < ready_count_);
+    --ready_count_;
+    bool edf = nullptr != ready_edf_;
+    unsigned int p = 0;
+    if ( 0 != ready_mask_) {
+        p = detail::highest( ready_mask_);
+        if ( ! edf && 0 == ( ready_mask_ & ( ( 1u << p) - 1) ) ) {
+            bypassed_ = 0;
+        } else if ( 0 != starvation_limit_ && starvation_limit_ <= ++bypassed_) {
+            // a context of a lower class waited too long, serve the lowest
+            // ready priority once
+            bypassed_ = 0;
+            p = detail::lowest( ready_mask_);
+            edf = false;
+        }
+    }
+    detail::task_record * t;
+    if ( edf) {
+        t = ready_edf_;
+        ready_edf_ = detail::merge( t->left, t->right);
+        t->left = nullptr;
+        t->right = nullptr;
+    } else {
+        t = ready_heads_[p];
+        ready_heads_[p] = t->nxt;
+        t->nxt = nullptr;
+        if ( nullptr == ready_heads_[p]) {
+            ready_tails_[p] = & ready_heads_[p];
+            ready_mask_ &= ~( 1u << p);
+        }
+    }
+    t->ready = false;
+    return t;
+}
+
+void
+scheduler::expire_timers_() noexcept {
+    if ( wheel_.empty() ) {
+        return;
+    }
+    // all timers expired since the last tick are handled as one batch
+    wheel_.advance( static_cast< std::uint64_t >( ( clock_type::now() - origin_) / resolution_) );
+    while ( timer_wheel::timer * t = wheel_.pop_expired() ) {
+        expire_( static_cast< detail::task_timer * >( t) );
+    }
+}
+
+void
+scheduler::expire_( detail::task_timer * tmr) noexcept {
+    tmr->task->tmo = nullptr;
+    if ( nullptr == tmr->fn || tmr->fn( tmr->vp) ) {
+        tmr->expired = true;
+        push_ready_( tmr->task);
+    }
+}
+
+std::uint64_t
+scheduler::to_tick_( clock_type::time_point tp) const noexcept {
+    if ( tp <= origin_) {
+        return 0;
+    }
+    // round up, timers never expire early
+    const clock_type::duration d = tp - origin_;
+    return static_cast< std::uint64_t >( d / resolution_) + ( clock_type::duration::zero() != d % resolution_ ? 1 : 0);
+}
+
+scheduler::clock_type::time_point
+scheduler::from_tick_( std::uint64_t tick) const noexcept {
+    if ( static_cast< std::uint64_t >( ( clock_type::time_point::max() - origin_) / resolution_) <= tick) {
+        return clock_type::time_point::max();
+    }
+    return origin_ + resolution_ * static_cast< clock_type::rep >( tick);
+}
+
+void
+scheduler::exit() noexcept {
+    BOOST_ASSERT( nullptr != running_);
+    running_->terminated = true;
+    // abandoned, not unwound when its stack is released
+    running_->ctx.finish_();
+    zombie_ = running_;
+    transfer_( nullptr);
+    BOOST_ASSERT_MSG( false, "terminated context resumed");
+    std::abort();
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
@@ -0,0 +1,87 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/semaphore.hpp"
+
+# include <mutex>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+
+semaphore::semaphore( std::ptrdiff_t count) noexcept :
+    splk_(),
+    count_( count),
+    waiters_() {
+    BOOST_ASSERT( 0 <= count_);
+}
+
+semaphore::~semaphore() {
+    BOOST_ASSERT( waiters_.empty() );
+}
+
+bool
+semaphore::acquire_( std::chrono::steady_clock::time_point deadline) noexcept {
+    // yields before the ownership is taken
+    detail::wait_queue::checkpoint();
+    splk_.lock();
+    if ( 0 < count_) {
+        --count_;
+        splk_.unlock();
+        return true;
+    }
+    detail::waiter w;
+    waiters_.push_back( & w);
+    // on wake-up a permit has been handed over by release()
+    return detail::wait_queue::suspend( & splk_, w, deadline);
+}
+
+bool
+semaphore::try_acquire() noexcept {
+    std::unique_lock< detail::spinlock > lk( splk_);
+    if ( 0 == count_) {
+        return false;
+    }
+    --count_;
+    return true;
+}
+
+void
+semaphore::release( std::ptrdiff_t update) noexcept {
+    BOOST_ASSERT( 0 <= update);
+    detail::waiter * head = nullptr;
+    detail::waiter ** tail = & head;
+    {
+        std::unique_lock< detail::spinlock > lk( splk_);
+        for ( ; 0 < update; --update) {
+            detail::waiter * w = waiters_.pop_front();
+            if ( nullptr == w) {
+                break;
+            }
+            * tail = w;
+            tail = & w->next;
+        }
+        count_ += update;
+    }
+    detail::wait_queue::wake_all( head);
+}
+
+}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
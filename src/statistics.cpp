@@ -0,0 +1,140 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/statistics.hpp"
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/statistics.hpp>
+
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+# include <mutex>
+# include <new>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+namespace detail {
+
+namespace {
+
+// all blocks ever allocated; blocks are never freed
+std::mutex              mtx;
+thread_counters     *   head = nullptr;
+// counters of terminated threads
+context_statistics      retired = {};
+// used by a thread after its block was released (thread-local
+// destructors running after the registrar)
+thread_counters         orphan;
+thread_local bool       exited = false;
+
+context_statistics snapshot( thread_counters const& c) noexcept {
+    context_statistics s;
+    s.switches = c.switches.load( std::memory_order_relaxed);
+    s.creations = c.creations.load( std::memory_order_relaxed);
+    s.destructions = c.destructions.load( std::memory_order_relaxed);
+    s.live = s.creations - s.destructions;
+    s.fixedsize_stack_bytes = c.stack_bytes[stack_fixedsize].load( std::memory_order_relaxed);
+    s.protected_fixedsize_stack_bytes = c.stack_bytes[stack_protected_fixedsize].load( std::memory_order_relaxed);
+    s.segmented_stack_bytes = c.stack_bytes[stack_segmented].load( std::memory_order_relaxed);
+    return s;
+}
+
+void reset( thread_counters & c) noexcept {
+    c.switches.store( 0, std::memory_order_relaxed);
+    c.creations.store( 0, std::memory_order_relaxed);
+    c.destructions.store( 0, std::memory_order_relaxed);
+    for ( std::atomic< std::int64_t > & b : c.stack_bytes) {
+        b.store( 0, std::memory_order_relaxed);
+    }
+}
+
+// releases the block of the thread at thread exit
+struct registrar {
+    ~registrar() {
+        thread_counters * c = thread_counters::current_;
+        std::unique_lock< std::mutex > lk( mtx);
+        retired += snapshot( * c);
+        reset( * c);
+        c->in_use = false;
+        thread_counters::current_ = nullptr;
+        exited = true;
+    }
+};
+
+}
+
+thread_local
+thread_counters *
+thread_counters::current_ = nullptr;
+
+thread_counters *
+thread_counters::attach() noexcept {
+    if ( exited) {
+        return & orphan;
+    }
+    thread_counters * c = nullptr;
+    {
+        std::unique_lock< std::mutex > lk( mtx);
+        for ( thread_counters * i = head; nullptr != i; i = i->nxt) {
+            if ( ! i->in_use) {
+                c = i;
+                break;
+            }
+        }
+        if ( nullptr == c) {
+            c = new ( std::nothrow) thread_counters();
+            if ( nullptr == c) {
+                return & orphan;
+            }
+            c->nxt = head;
+            head = c;
+        }
+        c->in_use = true;
+    }
+    current_ = c;
+    // destroyed at thread exit
+    thread_local static registrar r;
+    return c;
+}
+
+}
+
+context_statistics thread_statistics() noexcept {
+    return detail::snapshot( detail::thread_counters::current() );
+}
+
+context_statistics aggregate_statistics() noexcept {
+    std::unique_lock< std::mutex > lk( detail::mtx);
+    context_statistics s = detail::retired;
+    for ( detail::thread_counters * i = detail::head; nullptr != i; i = i->nxt) {
+        if ( i->in_use) {
+            s += detail::snapshot( * i);
+        }
+    }
+    s += detail::snapshot( detail::orphan);
+    return s;
+}
+#else
+context_statistics thread_statistics() noexcept {
+    return context_statistics();
+}
+
+context_statistics aggregate_statistics() noexcept {
+    return context_statistics();
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
@@ -0,0 +1,260 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "boost/context/trace.hpp"
+
+#include <ostream>
+
+#include <boost/config.hpp>
+
+#include <boost/context/detail/trace.hpp>
+
+#if defined(BOOST_CONTEXT_USE_TRACE)
+# include <algorithm>
+# include <chrono>
+# include <cstddef>
+# include <cstdio>
+# include <mutex>
+# include <new>
+# include <vector>
+#endif
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace context {
+
+#if defined(BOOST_CONTEXT_USE_TRACE)
+namespace detail {
+
+namespace {
+
+// all buffers ever allocated; buffers are never freed
+std::mutex                                  mtx;
+trace_buffer                            *   buffers = nullptr;
+std::uint32_t                               next_tid = 0;
+// pair of ticks() and steady_clock, taken at the first attach and
+// by trace_clear(); used to convert the time stamps
+bool                                        has_origin = false;
+std::uint64_t                               origin_ticks = 0;
+std::chrono::steady_clock::time_point       origin_time;
+
+struct event {
+    std::uint64_t   ts;
+    void const*     from;
+    void const*     to;
+    char const*     name;
+};
+
+void set_origin() noexcept {
+    origin_ticks = ticks();
+    origin_time = std::chrono::steady_clock::now();
+    has_origin = true;
+}
+
+thread_local bool                           exited = false;
+
+// releases the buffer of the thread at thread exit; the recorded events
+// remain exportable until the buffer is recycled
+struct registrar {
+    ~registrar() {
+        std::unique_lock< std::mutex > lk( mtx);
+        trace_buffer::current_->in_use = false;
+        trace_buffer::current_ = nullptr;
+        exited = true;
+    }
+};
+
+// copies the events of `b` that were not overwritten while copying
+std::vector< event > snapshot( trace_buffer const& b) {
+    std::vector< event > events;
+    const std::uint64_t last = b.head.load( std::memory_order_acquire);
+    std::uint64_t first = b.base.load( std::memory_order_relaxed);
+    if ( BOOST_CONTEXT_TRACE_EVENTS < last - first) {
+        first = last - BOOST_CONTEXT_TRACE_EVENTS;
+    }
+    for ( std::uint64_t i = first; i < last; ++i) {
+        trace_event const& e = b.events[i & ( BOOST_CONTEXT_TRACE_EVENTS - 1)];
+        event x;
+        x.ts = e.ts.load( std::memory_order_relaxed);
+        x.from = e.from.load( std::memory_order_relaxed);
+        x.to = e.to.load( std::memory_order_relaxed);
+        x.name = e.name.load( std::memory_order_relaxed);
+        events.push_back( x);
+    }
+    // the owner might have overwritten the oldest slots meanwhile,
+    // including the slot of the event in progress
+    std::atomic_thread_fence( std::memory_order_acquire);
+    const std::uint64_t now = b.head.load( std::memory_order_relaxed);
+    if ( first + BOOST_CONTEXT_TRACE_EVENTS <= now) {
+        const std::uint64_t valid = now - BOOST_CONTEXT_TRACE_EVENTS + 1;
+        const std::uint64_t stale = ( std::min)( valid - first, static_cast< std::uint64_t >( events.size() ) );
+        events.erase( events.begin(), events.begin() + static_cast< std::ptrdiff_t >( stale) );
+    }
+    return events;
+}
+
+void write_string( std::ostream & os, char const* s) {
+    os << '"';
+    for ( ; '\0' != * s; ++s) {
+        const char c = * s;
+        if ( '"' == c || '\\' == c) {
+            os << '\\' << c;
+        } else if ( 0x20 > static_cast< unsigned char >( c) ) {
+            char buf[8];
+            std::snprintf( buf, sizeof( buf), "\\u%04x", static_cast< unsigned int >( c) );
+            os << buf;
+        } else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+void write_address( std::ostream & os, void const* p) {
+    char buf[32];
+    std::snprintf( buf, sizeof( buf), "%p", p);
+    os << '"' << buf << '"';
+}
+
+}
+
+std::atomic< bool > trace_buffer::enabled_( true);
+
+thread_local
+trace_buffer *
+trace_buffer::current_ = nullptr;
+
+trace_buffer *
+trace_buffer::attach() noexcept {
+    // switches of thread-local destructors running after the registrar
+    if ( exited) {
+        return nullptr;
+    }
+    trace_buffer * b = nullptr;
+    {
+        std::unique_lock< std::mutex > lk( mtx);
+        for ( trace_buffer * i = buffers; nullptr != i; i = i->nxt) {
+            if ( ! i->in_use) {
+                b = i;
+                break;
+            }
+        }
+        if ( nullptr == b) {
+            b = new ( std::nothrow) trace_buffer();
+            if ( nullptr == b) {
+                return nullptr;
+            }
+            b->nxt = buffers;
+            buffers = b;
+        }
+        if ( ! has_origin) {
+            set_origin();
+        }
+        // drop the events of the previous owner
+        b->base.store( b->head.load( std::memory_order_relaxed), std::memory_order_relaxed);
+        b->tid = ++next_tid;
+        b->in_use = true;
+    }
+    current_ = b;
+    // destroyed at thread exit
+    thread_local static registrar r;
+    return b;
+}
+
+}
+
+void trace_enable( bool enable) noexcept {
+    detail::trace_buffer::enabled_.store( enable, std::memory_order_relaxed);
+}
+
+bool trace_enabled() noexcept {
+    return detail::trace_buffer::enabled_.load( std::memory_order_relaxed);
+}
+
+void trace_clear() noexcept {
+    std::unique_lock< std::mutex > lk( detail::mtx);
+    for ( detail::trace_buffer * i = detail::buffers; nullptr != i; i = i->nxt) {
+        i->base.store( i->head.load( std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    detail::set_origin();
+}
+
+void write_trace( std::ostream & os) {
+    std::unique_lock< std::mutex > lk( detail::mtx);
+    // time stamp -> microseconds since origin
+    double us_per_tick = 1e-3;
+    if ( detail::ticks_are_tsc) {
+        const std::uint64_t elapsed = detail::ticks() - detail::origin_ticks;
+        const double us = std::chrono::duration< double, std::micro >(
+                std::chrono::steady_clock::now() - detail::origin_time).count();
+        us_per_tick = 0 != elapsed ? us / static_cast< double >( elapsed) : 0.;
+    }
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+    os.setf( std::ios_base::fixed, std::ios_base::floatfield);
+    os.precision( 3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for ( detail::trace_buffer * b = detail::buffers; nullptr != b; b = b->nxt) {
+        const std::vector< detail::event > events = detail::snapshot( * b);
+        if ( events.empty() ) {
+            continue;
+        }
+        os << ( first ? "" : ",")
+           << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+           << ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+        first = false;
+        for ( std::size_t i = 0; i < events.size(); ++i) {
+            detail::event const& e = events[i];
+            const double ts = static_cast< double >( static_cast< std::int64_t >( e.ts - detail::origin_ticks) ) * us_per_tick;
+            os << ",\n{\"name\":";
+            if ( nullptr != e.name) {
+                detail::write_string( os, e.name);
+            } else {
+                detail::write_address( os, e.to);
+            }
+            os << ",\"cat\":\"context\",\"pid\":1,\"tid\":" << b->tid << ",\"ts\":" << ts;
+            if ( i + 1 < events.size() ) {
+                // the context ran until the next switch of this thread
+                os << ",\"ph\":\"X\",\"dur\":" << static_cast< double >( events[i + 1].ts - e.ts) * us_per_tick;
+            } else {
+                // still running
+                os << ",\"ph\":\"B\"";
+            }
+            os << ",\"args\":{\"from\":";
+            detail::write_address( os, e.from);
+            os << ",\"to\":";
+            detail::write_address( os, e.to);
+            os << "}}";
+        }
+    }
+    os << "\n]}\n";
+    os.flags( flags);
+    os.precision( precision);
+}
+#else
+void trace_enable( bool) noexcept {
+}
+
+bool trace_enabled() noexcept {
+    return false;
+}
+
+void trace_clear() noexcept {
+}
+
+void write_trace( std::ostream & os) {
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}\n";
+}
+#endif
+
+}}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+# include BOOST_ABI_SUFFIX
+#endif
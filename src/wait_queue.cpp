@@ -0,0 +1,200 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <boost/context/detail/config.hpp>
+
+#if ! defined(BOOST_CONTEXT_NO_EXECUTION_CONTEXT)
+
+# include "boost/context/detail/wait_queue.hpp"
+
+# include <mutex>
+
+# include <boost/assert.hpp>
+# include <boost/config.hpp>
+
+# include <boost/context/scheduler.hpp>
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+# endif
+
+namespace boost {
+namespace context {
+namespace detail {
+
+waiter::waiter() noexcept :
+    task( nullptr != scheduler::current() ? scheduler::current()->running_ : nullptr),
+    state( 0),
+    prev( nullptr),
+    next( nullptr),
+    queue( nullptr),
+    splk( nullptr),
+    selected( nullptr) {
+}
+
+void
+wait_queue::push_back( waiter * w) noexcept {
+    BOOST_ASSERT( nullptr != w);
+    BOOST_ASSERT( nullptr == w->queue);
+    w->prev = tail_;
+    w->next = nullptr;
+    if ( nullptr != tail_) {
+        tail_->next = w;
+    } else {
+        head_ = w;
+    }
+    tail_ = w;
+    w->queue = this;
+}
+
+waiter *
+wait_queue::pop_front() noexcept {
+    while ( nullptr != head_) {
+        waiter * w = head_;
+        remove( w);
+        if ( w->claim() ) {
+            return w;
+        }
+    }
+    return nullptr;
+}
+
+waiter *
+wait_queue::pop_all() noexcept {
+    waiter * head = nullptr;
+    waiter ** tail = & head;
+    while ( waiter * w = pop_front() ) {
+        * tail = w;
+        tail = & w->next;
+    }
+    return head;
+}
+
+void
+wait_queue::remove( waiter * w) noexcept {
+    BOOST_ASSERT( this == w->queue);
+    if ( nullptr != w->prev) {
+        w->prev->next = w->next;
+    } else {
+        head_ = w->next;
+    }
+    if ( nullptr != w->next) {
+        w->next->prev = w->prev;
+    } else {
+        tail_ = w->prev;
+    }
+    w->prev = w->next = nullptr;
+    w->queue = nullptr;
+}
+
+bool
+wait_queue::expire_( void * vp) noexcept {
+    waiter * w = static_cast< waiter * >( vp);
+    if ( nullptr != w->splk) {
+        w->splk->lock();
+    }
+    const bool linked = nullptr != w->queue;
+    if ( linked) {
+        w->queue->remove( w);
+    }
+    // not linked: popped by a notifier, the wake-up is under way
+    if ( nullptr != w->splk) {
+        w->splk->unlock();
+    }
+    return linked;
+}
+
+bool
+wait_queue::park( std::chrono::steady_clock::time_point deadline, bool (* fn)( void *), void * vp) noexcept {
+    scheduler * sched = scheduler::current();
+    BOOST_ASSERT( nullptr != sched);
+    BOOST_ASSERT( nullptr != sched->running_);
+    ++sched->blocked_;
+    const bool ok = sched->suspend_until_( deadline, fn, vp);
+    --sched->blocked_;
+    return ok;
+}
+
+void
+wait_queue::checkpoint() noexcept {
+    scheduler * sched = scheduler::current();
+    if ( nullptr != sched && nullptr != sched->running_ &&
+         sched->preempt_.load( std::memory_order_relaxed) ) {
+        sched->yield_();
+    }
+}
+
+bool
+wait_queue::suspend( spinlock * lk, waiter & w, std::chrono::steady_clock::time_point deadline) noexcept {
+    BOOST_ASSERT( nullptr != w.queue);
+    w.splk = lk;
+    if ( nullptr != w.task) {
+        // the context is not resumed before it has been suspended:
+        // a wake-up from the same thread requires the dispatcher to run,
+        // a wake-up from another thread is queued by ready_remote()
+        if ( nullptr != lk) {
+            lk->unlock();
+        }
+        return park( deadline, & wait_queue::expire_, & w);
+    }
+    // no other thread could wake a plain thread
+    BOOST_ASSERT( nullptr != lk);
+    lk->unlock();
+    while ( 0 == w.state.load( std::memory_order_acquire) ) {
+        if ( std::chrono::steady_clock::now() >= deadline) {
+            {
+                std::unique_lock< spinlock > guard( * lk);
+                if ( nullptr != w.queue) {
+                    w.queue->remove( & w);
+                    return false;
+                }
+            }
+            // popped by a notifier, wait for the wake-up
+            while ( 0 == w.state.load( std::memory_order_acquire) ) {
+                futex_wait( & w.state, 0);
+            }
+            break;
+        }
+        futex_wait( & w.state, 0, deadline);
+    }
+    return true;
+}
+
+void
+wait_queue::wake( waiter * w) noexcept {
+    BOOST_ASSERT( nullptr != w);
+    BOOST_ASSERT( nullptr == w->queue);
+    task_record * t = w->task;
+    if ( nullptr != t) {
+        // `w` is gone as soon as the context is resumed
+        if ( scheduler::current() == t->sched) {
+            t->sched->ready_( t);
+        } else {
+            t->sched->ready_remote_( t);
+        }
+        return;
+    }
+    futex_type * state = & w->state;
+    state->store( 1, std::memory_order_release);
+    // waking an address that is no longer waited on is harmless
+    futex_wake( state, 1);
+}
+
+void
+wait_queue::wake_all( waiter * w) noexcept {
+    while ( nullptr != w) {
+        waiter * nxt = w->next;
+        wake( w);
+        w = nxt;
+    }
+}
+
+}}}
+
+# ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+# endif
+
+#endif
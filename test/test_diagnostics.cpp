@@ -0,0 +1,343 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <boost/assert.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/context/all.hpp>
+#include <boost/context/detail/config.hpp>
+
+namespace ctx = boost::context;
+
+void test_statistics() {
+    const ctx::context_statistics before = ctx::thread_statistics();
+    {
+        ctx::execution_context mctx( ctx::execution_context::current() );
+        ctx::fixedsize_stack salloc( ctx::stack_traits::minimum_size() );
+        ctx::execution_context ectx(
+            std::allocator_arg, salloc,
+            [&mctx]( void *) {
+                while ( true) {
+                    mctx();
+                }
+            });
+        const ctx::context_statistics running = ctx::thread_statistics();
+        BOOST_CHECK_EQUAL( before.creations + 1, running.creations);
+        BOOST_CHECK_EQUAL( before.live + 1, running.live);
+        BOOST_CHECK_EQUAL( before.fixedsize_stack_bytes + static_cast< std::int64_t >( ctx::stack_traits::minimum_size() ),
+                           running.fixedsize_stack_bytes);
+        for ( int i = 0; i < 10; ++i) {
+            ectx();
+        }
+        // each round trip switches twice
+        BOOST_CHECK_LE( running.switches + 20, ctx::thread_statistics().switches);
+    }
+    const ctx::context_statistics after = ctx::thread_statistics();
+    BOOST_CHECK_EQUAL( before.destructions + 1, after.destructions);
+    BOOST_CHECK_EQUAL( before.live, after.live);
+    BOOST_CHECK_EQUAL( before.fixedsize_stack_bytes, after.fixedsize_stack_bytes);
+}
+
+void test_statistics_aggregate() {
+    const ctx::context_statistics before = ctx::aggregate_statistics();
+    std::int64_t switches = 0;
+    std::thread t( [&switches](){
+                ctx::execution_context mctx( ctx::execution_context::current() );
+                ctx::execution_context ectx(
+                    [&mctx]( void *) {
+                        while ( true) {
+                            mctx();
+                        }
+                    });
+                ectx();
+                switches = ctx::thread_statistics().switches;
+             });
+    t.join();
+    // the counters of terminated threads are retained
+    const ctx::context_statistics after = ctx::aggregate_statistics();
+    BOOST_CHECK_EQUAL( before.creations + 1, after.creations);
+    BOOST_CHECK_EQUAL( before.destructions + 1, after.destructions);
+    BOOST_CHECK_LE( before.switches + switches, after.switches);
+    BOOST_CHECK_EQUAL( before.fixedsize_stack_bytes, after.fixedsize_stack_bytes);
+}
+
+void test_name() {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context ectx(
+        [&mctx]( void *) {
+            while ( true) {
+                mctx();
+            }
+        });
+    BOOST_CHECK( nullptr == ectx.name() );
+    ectx.name("worker");
+    BOOST_CHECK_EQUAL( std::string("worker"), ectx.name() );
+    // the name belongs to the context, not to the handle
+    ctx::execution_context const& ref = ectx;
+    ctx::execution_context copy( ref);
+    BOOST_CHECK_EQUAL( std::string("worker"), copy.name() );
+}
+
+void test_trace() {
+    ctx::trace_clear();
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context ectx(
+        [&mctx]( void *) {
+            while ( true) {
+                mctx();
+            }
+        });
+    ectx.name("worker");
+    for ( int i = 0; i < 5; ++i) {
+        ectx();
+    }
+    ctx::trace_enable( false);
+    ectx();
+    ctx::trace_enable( true);
+    std::ostringstream os;
+    ctx::write_trace( os);
+    // valid JSON, one slice per resumption of `ectx`
+    std::istringstream is( os.str() );
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json( is, pt);
+    int slices = 0;
+    for ( auto const& e : pt.get_child("traceEvents") ) {
+        if ( "worker" == e.second.get< std::string >("name") ) {
+            BOOST_CHECK_LE( 0., e.second.get< double >("ts") );
+            ++slices;
+        }
+    }
+    BOOST_CHECK_EQUAL( 5, slices);
+}
+
+void test_accounting() {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context busy(
+        [&mctx]( void *) {
+            while ( true) {
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                while ( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 2) ) {
+                }
+                mctx();
+            }
+        });
+    busy.name("busy");
+    ctx::execution_context idle(
+        [&mctx]( void *) {
+            while ( true) {
+                mctx();
+            }
+        });
+    idle.name("idle");
+    const std::uint64_t resumes = busy.resumes();
+    for ( int i = 0; i < 5; ++i) {
+        busy();
+        idle();
+    }
+    BOOST_CHECK_EQUAL( resumes + 5, busy.resumes() );
+    BOOST_CHECK_EQUAL( resumes + 5, idle.resumes() );
+    BOOST_CHECK( std::chrono::milliseconds( 9) < busy.cpu_time() );
+    BOOST_CHECK( idle.cpu_time() < busy.cpu_time() );
+    // the running context includes its current slice
+    const std::chrono::nanoseconds running = mctx.cpu_time();
+    BOOST_CHECK( running < mctx.cpu_time() );
+    // ordered by cpu_time
+    const std::vector< ctx::context_usage > top = ctx::top_contexts( 100);
+    int busy_pos = -1, idle_pos = -1;
+    for ( std::size_t i = 0; i < top.size(); ++i) {
+        if ( 0 < i) {
+            BOOST_CHECK( top[i].cpu_time <= top[i - 1].cpu_time);
+        }
+        if ( nullptr != top[i].name && std::string("busy") == top[i].name) {
+            busy_pos = static_cast< int >( i);
+            BOOST_CHECK_EQUAL( busy.resumes(), top[i].resumes);
+        } else if ( nullptr != top[i].name && std::string("idle") == top[i].name) {
+            idle_pos = static_cast< int >( i);
+        }
+    }
+    BOOST_CHECK( -1 != busy_pos);
+    BOOST_CHECK( busy_pos < idle_pos);
+    BOOST_CHECK_EQUAL( 1u, ctx::top_contexts( 1).size() );
+}
+
+void test_latency_histogram() {
+    ctx::latency_histogram h;
+    BOOST_CHECK_EQUAL( 0u, h.count() );
+    BOOST_CHECK( std::chrono::nanoseconds::zero() == h.percentile( 99.) );
+    for ( int i = 1; i <= 1000; ++i) {
+        h.record( std::chrono::microseconds( i) );
+    }
+    BOOST_CHECK_EQUAL( 1000u, h.count() );
+    // relative error below 1/32
+    const double p50 = static_cast< double >( h.percentile( 50.).count() );
+    BOOST_CHECK_CLOSE( 500000., p50, 100. / 32.);
+    const double p99 = static_cast< double >( h.percentile( 99.).count() );
+    BOOST_CHECK_CLOSE( 990000., p99, 100. / 32.);
+    BOOST_CHECK( h.min() <= std::chrono::microseconds( 1) );
+    BOOST_CHECK( h.max() >= std::chrono::microseconds( 1000) );
+    ctx::latency_histogram other;
+    other.record( std::chrono::milliseconds( 5), 10);
+    h += other;
+    BOOST_CHECK_EQUAL( 1010u, h.count() );
+    BOOST_CHECK( h.percentile( 100.) >= std::chrono::milliseconds( 5) );
+    // the buckets of the highest power of two exceed nanoseconds::max()
+    for ( std::size_t i = 1; i < ctx::latency_histogram::buckets - 32; ++i) {
+        BOOST_CHECK( ctx::latency_histogram::lower_bound( i) == ctx::latency_histogram::upper_bound( i - 1) + std::chrono::nanoseconds( 1) );
+    }
+    std::ostringstream os;
+    h.write_json( os);
+    std::istringstream is( os.str() );
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json( is, pt);
+    BOOST_CHECK_EQUAL( 1010u, pt.get< std::size_t >("count") );
+}
+
+void test_switch_histograms() {
+    ctx::reset_histograms();
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context hog(
+        [&mctx]( void *) {
+            while ( true) {
+                const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                while ( std::chrono::steady_clock::now() - start < std::chrono::milliseconds( 2) ) {
+                }
+                mctx();
+            }
+        });
+    for ( int i = 0; i < 10; ++i) {
+        hog();
+    }
+    const ctx::switch_histograms h = ctx::thread_histograms();
+    // 10 resumptions of `hog`, 10 returns to the main context
+    BOOST_CHECK_LE( 20u, h.run_slice.count() );
+    BOOST_CHECK_LE( 10u, h.suspended.count() );
+    // the slices of `hog` are the slowest tenth
+    BOOST_CHECK( h.run_slice.percentile( 100.) >= std::chrono::milliseconds( 2) );
+    BOOST_CHECK( h.suspended.percentile( 100.) >= std::chrono::milliseconds( 2) );
+    BOOST_CHECK_LE( h.run_slice.count(), ctx::aggregate_histograms().run_slice.count() );
+    std::ostringstream os;
+    ctx::write_json( os, h);
+    std::istringstream is( os.str() );
+    boost::property_tree::ptree pt;
+    boost::property_tree::read_json( is, pt);
+    BOOST_CHECK_EQUAL( h.run_slice.count(), pt.get< std::uint64_t >("run_slice.count") );
+    std::ostringstream txt;
+    ctx::write_text( txt, h);
+    BOOST_CHECK( std::string::npos != txt.str().find("run slice: count") );
+}
+
+BOOST_NOINLINE
+void parked_here( ctx::execution_context & mctx) {
+    mctx();
+#if defined(__GNUC__)
+    // prevents a tail call
+    __asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+void test_backtraces() {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context ectx(
+        [&mctx]( void *) {
+            while ( true) {
+                parked_here( mctx);
+            }
+        });
+    ectx.name("parked");
+    ectx();
+    bool found = false;
+    for ( ctx::context_backtrace const& bt : ctx::context_backtraces() ) {
+        if ( nullptr != bt.name && std::string("parked") == bt.name) {
+            found = true;
+            BOOST_CHECK( ! bt.running);
+            BOOST_CHECK( ! bt.frames.empty() );
+        }
+    }
+    BOOST_CHECK( found);
+    std::ostringstream os;
+    ctx::write_backtraces( os);
+    BOOST_CHECK( std::string::npos != os.str().find("\"parked\" (suspended)") );
+#if defined(__x86_64__) && defined(__linux__)
+    BOOST_CHECK( std::string::npos != os.str().find("parked_here") );
+#endif
+}
+
+BOOST_NOINLINE
+void burn_here( std::chrono::milliseconds d) {
+    // the samples hit the loop, not the clock (no frame pointer in the vDSO)
+    const std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now() + d;
+    volatile unsigned long x = 0;
+    do {
+        for ( int i = 0; i < 100000; ++i) {
+            x = x + i;
+        }
+    } while ( std::chrono::steady_clock::now() < until);
+}
+
+void test_profiler() {
+    ctx::execution_context mctx( ctx::execution_context::current() );
+    ctx::execution_context ectx(
+        [&mctx]( void *) {
+            while ( true) {
+                burn_here( std::chrono::milliseconds( 100) );
+                mctx();
+            }
+        });
+    ectx.name("burner");
+    ctx::profiler_clear();
+    BOOST_CHECK( ctx::profiler_start( std::chrono::microseconds( 500) ) );
+    ectx();
+    ctx::profiler_stop();
+    BOOST_CHECK( 0 < ctx::profiler_samples() );
+    std::ostringstream os;
+    ctx::write_profile( os);
+    BOOST_CHECK( std::string::npos != os.str().find("burner;") );
+    BOOST_CHECK( std::string::npos != os.str().find("burn_here") );
+    // the samples are kept after the timer was stopped
+    const std::size_t n = ctx::profiler_samples();
+    burn_here( std::chrono::milliseconds( 10) );
+    BOOST_CHECK_EQUAL( n, ctx::profiler_samples() );
+    ctx::profiler_clear();
+    BOOST_CHECK_EQUAL( 0u, ctx::profiler_samples() );
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* [])
+{
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Context: diagnostics test suite");
+
+    test->add( BOOST_TEST_CASE( & test_name) );
+    test->add( BOOST_TEST_CASE( & test_latency_histogram) );
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+    test->add( BOOST_TEST_CASE( & test_statistics) );
+    test->add( BOOST_TEST_CASE( & test_statistics_aggregate) );
+#endif
+#if defined(BOOST_CONTEXT_USE_TRACE)
+    test->add( BOOST_TEST_CASE( & test_trace) );
+#endif
+#if defined(BOOST_CONTEXT_USE_ACCOUNTING)
+    test->add( BOOST_TEST_CASE( & test_accounting) );
+#endif
+#if defined(BOOST_CONTEXT_USE_HISTOGRAMS)
+    test->add( BOOST_TEST_CASE( & test_switch_histograms) );
+#endif
+#if defined(BOOST_CONTEXT_USE_REGISTRY)
+    test->add( BOOST_TEST_CASE( & test_backtraces) );
+#endif
+#if defined(BOOST_CONTEXT_USE_PROFILER) && defined(__x86_64__) && defined(__linux__)
+    test->add( BOOST_TEST_CASE( & test_profiler) );
+#endif
+
+    return test;
+}
@@ -142,12 +142,171 @@ void test_prealloc() {
     BOOST_CHECK_EQUAL( 7, value1);
 }
 
+struct counted {
+    static int  destroyed;
+
+    int value;
+
+    explicit counted( int value_) :
+        value( value_) {
+    }
+
+    ~counted() {
+        ++destroyed;
+    }
+};
+
+int counted::destroyed = 0;
+
+ctx::context_specific_ptr< counted > local;
+
+void fn_local( int i, void * vp) {
+    BOOST_CHECK( nullptr == local.get() );
+    local.reset( new counted( i) );
+    ctx::execution_context * mctx = static_cast< ctx::execution_context * >( vp);
+    ( * mctx)();
+    value1 = local->value;
+    ( * mctx)();
+}
+
+void test_context_specific_ptr() {
+    value1 = 0;
+    counted::destroyed = 0;
+    local.reset( new counted( 0) );
+    {
+        ctx::execution_context ctx( ctx::execution_context::current() );
+        ctx::execution_context ectx1( fn_local, 1);
+        ctx::execution_context ectx2( fn_local, 2);
+        ectx1( & ctx);
+        ectx2( & ctx);
+        BOOST_CHECK_EQUAL( 0, local->value);
+        ectx1();
+        BOOST_CHECK_EQUAL( 1, value1);
+        ectx2();
+        BOOST_CHECK_EQUAL( 2, value1);
+        BOOST_CHECK_EQUAL( 0, counted::destroyed);
+    }
+    // deallocating the contexts cleaned up their values
+    BOOST_CHECK_EQUAL( 2, counted::destroyed);
+    BOOST_CHECK_EQUAL( 0, local->value);
+    local.reset();
+    BOOST_CHECK_EQUAL( 3, counted::destroyed);
+}
+
+void fn_unwind( int i, void * vp) {
+    counted c( i);
+    ctx::execution_context * mctx = static_cast< ctx::execution_context * >( vp);
+    while ( true) {
+        ( * mctx)();
+        ++value1;
+    }
+}
+
+void test_unwind() {
+    value1 = 0;
+    counted::destroyed = 0;
+    {
+        ctx::execution_context ctx( ctx::execution_context::current() );
+        ctx::execution_context ectx( fn_unwind, 1);
+        ectx( & ctx);
+        ectx();
+        BOOST_CHECK_EQUAL( 1, value1);
+        BOOST_CHECK_EQUAL( 0, counted::destroyed);
+    }
+    // the suspended context was unwound before its stack was released
+    BOOST_CHECK_EQUAL( 1, value1);
+    BOOST_CHECK_EQUAL( 1, counted::destroyed);
+    // never resumed, the context-function is not entered
+    {
+        ctx::execution_context ectx( fn_unwind, 2);
+    }
+    BOOST_CHECK_EQUAL( 1, counted::destroyed);
+}
+
+void test_cancellation() {
+    value1 = 0;
+    counted::destroyed = 0;
+    ctx::cancellation_token token;
+    ctx::execution_context ctx( ctx::execution_context::current() );
+    ctx::execution_context ectx( fn_unwind, 1);
+    ectx.cancellation( token);
+    BOOST_CHECK( token == ectx.cancellation() );
+    ectx( & ctx);
+    ectx();
+    BOOST_CHECK_EQUAL( 1, value1);
+    token.cancel();
+    BOOST_CHECK( ectx.cancellation().cancelled() );
+    // resumed with forced_unwind, returns once the stack has been unwound
+    ectx();
+    BOOST_CHECK_EQUAL( 1, value1);
+    BOOST_CHECK_EQUAL( 1, counted::destroyed);
+    // the main context is never unwound
+    ctx::cancellation_token main_token;
+    ctx.cancellation( main_token);
+    main_token.cancel();
+    ctx::execution_context ectx2( fn_unwind, 2);
+    ectx2( & ctx);
+    BOOST_CHECK_EQUAL( 1, counted::destroyed);
+}
+
+void fn_throw( int i, void * vp) {
+    counted c( i);
+    ctx::execution_context * mctx = static_cast< ctx::execution_context * >( vp);
+    ( * mctx)();
+    throw std::runtime_error("fn_throw");
+}
+
+void fn_rethrow( void *) {
+    ctx::execution_context ctx( ctx::execution_context::current() );
+    ctx::execution_context ectx( fn_throw, 2);
+    ectx( & ctx);
+    try {
+        ectx();
+    } catch ( std::runtime_error const&) {
+        value1 = 2;
+        throw;
+    }
+}
+
+void test_propagation() {
+    value1 = 0;
+    counted::destroyed = 0;
+    {
+        ctx::execution_context ctx( ctx::execution_context::current() );
+        ctx::execution_context ectx( fn_throw, 1);
+        ectx( & ctx);
+        BOOST_CHECK_EQUAL( 0, counted::destroyed);
+        // the exception leaves the context-function and is rethrown here,
+        // the stack of the context has been unwound
+        BOOST_CHECK_THROW( ectx(), std::runtime_error);
+        BOOST_CHECK_EQUAL( 1, counted::destroyed);
+    }
+    BOOST_CHECK_EQUAL( 1, counted::destroyed);
+    // rethrown by the context-function of an intermediate context
+    {
+        ctx::execution_context ectx( fn_rethrow);
+        BOOST_CHECK_THROW( ectx(), std::runtime_error);
+        BOOST_CHECK_EQUAL( 2, value1);
+        BOOST_CHECK_EQUAL( 2, counted::destroyed);
+    }
+    // no exception pending after it has been rethrown
+    ctx::execution_context ctx( ctx::execution_context::current() );
+    ctx::execution_context ectx( fn_unwind, 3);
+    ectx( & ctx);
+    ectx();
+    BOOST_CHECK_EQUAL( 3, value1);
+}
+
 boost::unit_test::test_suite * init_unit_test_suite( int, char* [])
 {
     boost::unit_test::test_suite * test =
         BOOST_TEST_SUITE("Boost.Context: execution_context test suite");
 
     test->add( BOOST_TEST_CASE( & test_ectx) );
+    test->add( BOOST_TEST_CASE( & test_context_specific_ptr) );
+    test->add( BOOST_TEST_CASE( & test_unwind) );
+    test->add( BOOST_TEST_CASE( & test_cancellation) );
+    test->add( BOOST_TEST_CASE( & test_propagation) );
 #if 0
     test->add( BOOST_TEST_CASE( & test_variadric) );
     test->add( BOOST_TEST_CASE( & test_memfn) );
@@ -0,0 +1,606 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+extern "C" {
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/context/all.hpp>
+#include <boost/context/detail/config.hpp>
+
+namespace ctx = boost::context;
+
+std::vector< int > trace;
+
+void fn1( int i) {
+    trace.push_back( i);
+    ctx::scheduler::current()->yield();
+    trace.push_back( i + 10);
+}
+
+void test_yield() {
+    trace.clear();
+    ctx::scheduler s;
+    s.spawn( fn1, 1);
+    s.spawn( fn1, 2);
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    BOOST_REQUIRE_EQUAL( 4u, trace.size() );
+    BOOST_CHECK_EQUAL( 1, trace[0]);
+    BOOST_CHECK_EQUAL( 2, trace[1]);
+    BOOST_CHECK_EQUAL( 11, trace[2]);
+    BOOST_CHECK_EQUAL( 12, trace[3]);
+}
+
+void test_sleep() {
+    trace.clear();
+    ctx::scheduler s;
+    s.spawn( [](){
+                ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 20) );
+                trace.push_back( 2);
+             });
+    s.spawn( [](){
+                ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 5) );
+                trace.push_back( 1);
+             });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    s.run();
+    BOOST_CHECK( std::chrono::milliseconds( 20) <= std::chrono::steady_clock::now() - start);
+    BOOST_REQUIRE_EQUAL( 2u, trace.size() );
+    BOOST_CHECK_EQUAL( 1, trace[0]);
+    BOOST_CHECK_EQUAL( 2, trace[1]);
+}
+
+void test_suspend_until() {
+    ctx::scheduler s;
+    ctx::task_handle waiter;
+    bool woken = false, timed_out = false;
+    s.spawn( [&waiter,&woken](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                waiter = sched->running();
+                woken = sched->suspend_until(
+                    std::chrono::steady_clock::now() + std::chrono::seconds( 10) );
+             });
+    s.spawn( [&waiter](){
+                ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 1) );
+                ctx::scheduler::current()->ready( waiter);
+             });
+    s.spawn( [&timed_out](){
+                timed_out = ! ctx::scheduler::current()->suspend_until(
+                    std::chrono::steady_clock::now() + std::chrono::milliseconds( 2) );
+             });
+    s.run();
+    BOOST_CHECK( woken);
+    BOOST_CHECK( timed_out);
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+}
+
+// runs for `d`, yielding only on request of the watchdog
+int hog( std::chrono::milliseconds d, ctx::mutex * mtx) {
+    int yields = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while ( std::chrono::steady_clock::now() - start < d) {
+        if ( nullptr != mtx) {
+            // uncontended, the primitive checks the time slice
+            mtx->lock();
+            mtx->unlock();
+        } else if ( ctx::maybe_yield() ) {
+            ++yields;
+        }
+    }
+    return yields;
+}
+
+void test_time_slice() {
+    for ( int with_mutex = 0; with_mutex < 2; ++with_mutex) {
+        ctx::mutex mtx;
+        bool done = false;
+        bool preempted = false;
+        int yields = 0;
+        ctx::scheduler s;
+        BOOST_CHECK( ! ctx::maybe_yield() );
+        s.time_slice( std::chrono::milliseconds( 2) );
+        s.spawn( [&](){
+                    yields = hog( std::chrono::milliseconds( 100), with_mutex ? & mtx : nullptr);
+                    done = true;
+                 });
+        s.spawn( [&](){
+                    // runs before the hog finished only if the hog yielded
+                    preempted = ! done;
+                 });
+        s.run();
+        BOOST_CHECK( preempted);
+        if ( ! with_mutex) {
+            BOOST_CHECK_LE( 1, yields);
+        }
+    }
+    // disabled: the hog runs to completion
+    bool done = false;
+    bool preempted = true;
+    ctx::scheduler s;
+    s.spawn( [&](){
+                hog( std::chrono::milliseconds( 10), nullptr);
+                done = true;
+             });
+    s.spawn( [&](){
+                preempted = ! done;
+             });
+    s.run();
+    BOOST_CHECK( ! preempted);
+}
+
+void test_priority() {
+    trace.clear();
+    ctx::scheduler s;
+    s.spawn( fn1, 1);
+    s.spawn( ctx::task_attributes( 3), fn1, 2);
+    s.spawn( ctx::task_attributes( ctx::scheduler::max_priority),
+             std::allocator_arg, ctx::fixedsize_stack(), fn1, 3);
+    s.spawn( ctx::task_attributes( 3), fn1, 4);
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    // higher priorities first, FIFO within a priority
+    const int expected[] = { 3, 13, 2, 4, 12, 14, 1, 11 };
+    BOOST_REQUIRE_EQUAL( 8u, trace.size() );
+    for ( std::size_t i = 0; i < trace.size(); ++i) {
+        BOOST_CHECK_EQUAL( expected[i], trace[i]);
+    }
+    // the running context changes its class
+    trace.clear();
+    s.spawn( [](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                BOOST_CHECK_EQUAL( 0u, sched->attributes().priority);
+                sched->attributes( ctx::task_attributes( 1) );
+                sched->yield();
+                trace.push_back( 1);
+             });
+    s.spawn( [](){
+                ctx::scheduler::current()->yield();
+                trace.push_back( 2);
+             });
+    s.run();
+    BOOST_REQUIRE_EQUAL( 2u, trace.size() );
+    BOOST_CHECK_EQUAL( 1, trace[0]);
+    BOOST_CHECK_EQUAL( 2, trace[1]);
+}
+
+void test_deadline() {
+    trace.clear();
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    ctx::scheduler s;
+    s.spawn( ctx::task_attributes( ctx::scheduler::max_priority), fn1, 1);
+    s.spawn( ctx::task_attributes( 0, now + std::chrono::seconds( 3) ), fn1, 3);
+    s.spawn( ctx::task_attributes( 0, now + std::chrono::seconds( 1) ), fn1, 2);
+    s.spawn( ctx::task_attributes( 0, now + std::chrono::seconds( 3) ), fn1, 4);
+    s.run();
+    // contexts with a deadline precede all priorities, earliest deadline
+    // first, arrival order among equal deadlines
+    const int expected[] = { 2, 12, 3, 4, 13, 14, 1, 11 };
+    BOOST_REQUIRE_EQUAL( 8u, trace.size() );
+    for ( std::size_t i = 0; i < trace.size(); ++i) {
+        BOOST_CHECK_EQUAL( expected[i], trace[i]);
+    }
+}
+
+void test_starvation() {
+    for ( std::size_t limit = 0; limit < 2; ++limit) {
+        const int rounds = 100;
+        int high = 0;
+        int low_at = -1;
+        ctx::scheduler s;
+        s.starvation_limit( limit * 8);
+        s.spawn( ctx::task_attributes( 1), [&](){
+                    for ( ; high < rounds; ++high) {
+                        ctx::scheduler::current()->yield();
+                    }
+                 });
+        s.spawn( [&](){
+                    low_at = high;
+                 });
+        s.run();
+        if ( 0 == limit) {
+            // strict priorities, the low context waits for the high one
+            BOOST_CHECK_EQUAL( rounds, low_at);
+        } else {
+            BOOST_CHECK_LE( 0, low_at);
+            BOOST_CHECK_GT( 10, low_at);
+        }
+    }
+}
+
+void test_switch_to() {
+    const int items = 1000;
+    std::vector< int > received;
+    ctx::task_handle consumer;
+    ctx::task_handle producer;
+    int value = 0;
+    ctx::scheduler s;
+    s.spawn( [&](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                consumer = sched->running();
+                sched->suspend();
+                while ( 0 <= value) {
+                    received.push_back( value);
+                    sched->switch_to( producer);
+                }
+             });
+    s.spawn( [&](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                producer = sched->running();
+                const ctx::context_statistics before = ctx::thread_statistics();
+                for ( int i = 0; i < items; ++i) {
+                    value = i;
+                    // the consumer runs next, it hands control straight back
+                    sched->switch_to( consumer);
+                }
+                const ctx::context_statistics after = ctx::thread_statistics();
+#if defined(BOOST_CONTEXT_USE_STATISTICS)
+                // one switch each way, none via the dispatcher
+                BOOST_CHECK_EQUAL( 2 * items, after.switches - before.switches);
+#else
+                BOOST_CHECK_EQUAL( 0, after.switches - before.switches);
+#endif
+                value = -1;
+                sched->ready( consumer);
+             });
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    BOOST_REQUIRE_EQUAL( std::size_t( items), received.size() );
+    for ( int i = 0; i < items; ++i) {
+        BOOST_CHECK_EQUAL( i, received[i]);
+    }
+    // yield_to() keeps the yielding context ready
+    trace.clear();
+    ctx::task_handle waiter;
+    s.spawn( [&waiter](){
+                ctx::scheduler * sched = ctx::scheduler::current();
+                waiter = sched->running();
+                // woken by yield_to() before its timeout
+                BOOST_CHECK( sched->suspend_until(
+                                std::chrono::steady_clock::now() + std::chrono::seconds( 10) ) );
+                trace.push_back( 2);
+             });
+    s.spawn( fn1, 3);
+    s.spawn( [&waiter](){
+                trace.push_back( 1);
+                ctx::scheduler::current()->yield_to( waiter);
+                trace.push_back( 4);
+             });
+    s.run();
+    const int expected[] = { 3, 1, 2, 13, 4 };
+    BOOST_REQUIRE_EQUAL( 5u, trace.size() );
+    for ( std::size_t i = 0; i < trace.size(); ++i) {
+        BOOST_CHECK_EQUAL( expected[i], trace[i]);
+    }
+}
+
+// sets a flag on destruction, observes stack unwinding
+struct guard {
+    bool    &   flag;
+
+    explicit guard( bool & flag_) :
+        flag( flag_) {
+    }
+
+    ~guard() {
+        flag = true;
+    }
+};
+
+void test_nursery() {
+    ctx::scheduler s;
+    s.spawn( [](){
+                const ctx::context_statistics before = ctx::thread_statistics();
+                int sum = 0;
+                {
+                    ctx::nursery n;
+                    for ( int i = 1; i <= 100; ++i) {
+                        n.spawn( [&sum]( int v){
+                                    ctx::scheduler::current()->yield();
+                                    sum += v;
+                                 }, i);
+                    }
+                    BOOST_CHECK_EQUAL( 100u, n.size() );
+                    n.join();
+                    BOOST_CHECK_EQUAL( 0u, n.size() );
+                    BOOST_CHECK_EQUAL( 5050, sum);
+                    // the stacks are recycled by later children
+                    for ( int i = 0; i < 10; ++i) {
+                        n.spawn( [&sum](){ ++sum; });
+                        n.join();
+                    }
+                    BOOST_CHECK_EQUAL( 5060, sum);
+                }
+                const ctx::context_statistics after = ctx::thread_statistics();
+                // all stacks have been returned to the allocator
+                BOOST_CHECK_EQUAL( before.fixedsize_stack_bytes, after.fixedsize_stack_bytes);
+             });
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    // the first exception cancels the siblings and is rethrown by join()
+    s.spawn( [](){
+                int started = 0;
+                bool unwound = false, resumed = false;
+                ctx::nursery n;
+                n.spawn( [&](){
+                            ++started;
+                            guard g( unwound);
+                            // unwound when resumed after the cancellation
+                            ctx::scheduler::current()->yield();
+                            resumed = true;
+                         });
+                n.spawn( [&](){
+                            ++started;
+                            throw std::runtime_error("failed");
+                         });
+                n.spawn( [&](){
+                            ++started;
+                         });
+                n.spawn( [&](){
+                            ++started;
+                         });
+                bool thrown = false;
+                try {
+                    n.join();
+                } catch ( std::runtime_error const& e) {
+                    thrown = std::string("failed") == e.what();
+                }
+                BOOST_CHECK( thrown);
+                BOOST_CHECK( n.cancelled() );
+                BOOST_CHECK( unwound);
+                BOOST_CHECK( ! resumed);
+                // the children after the failing one were not yet started
+                BOOST_CHECK_EQUAL( 2, started);
+                // a nursery joins its children on destruction
+                n.spawn( [&](){
+                            ctx::scheduler::current()->yield();
+                            ++started;
+                         });
+             });
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    // the cancellation wakes sleeping children
+    s.spawn( [](){
+                bool unwound = false, resumed = false;
+                ctx::nursery n;
+                n.spawn( [&](){
+                            guard g( unwound);
+                            ctx::scheduler::current()->sleep_for( std::chrono::seconds( 10) );
+                            resumed = true;
+                         });
+                n.spawn( [&](){
+                            ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 1) );
+                            throw std::runtime_error("failed");
+                         });
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                BOOST_CHECK_THROW( n.join(), std::runtime_error);
+                BOOST_CHECK( std::chrono::seconds( 1) > std::chrono::steady_clock::now() - start);
+                BOOST_CHECK( unwound);
+                BOOST_CHECK( ! resumed);
+             });
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+}
+
+void test_cancel() {
+    ctx::scheduler s;
+    ctx::task_handle sleeper;
+    bool unwound = false, resumed = false;
+    s.spawn( [&](){
+                sleeper = ctx::scheduler::current()->running();
+                guard g( unwound);
+                ctx::scheduler::current()->sleep_for( std::chrono::seconds( 10) );
+                resumed = true;
+             });
+    s.spawn( [&](){
+                ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 1) );
+                ctx::scheduler::current()->cancel( sleeper);
+             });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    s.run();
+    BOOST_CHECK( std::chrono::seconds( 1) > std::chrono::steady_clock::now() - start);
+    BOOST_CHECK( unwound);
+    BOOST_CHECK( ! resumed);
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+}
+
+void test_destroy() {
+    bool suspended = false, joined = false, child = false, unstarted = false;
+    {
+        ctx::scheduler s;
+        // waits for a ready() that is never called
+        s.spawn( [&suspended](){
+                    guard g( suspended);
+                    ctx::scheduler::current()->suspend();
+                 });
+        // joins a child that never terminates
+        s.spawn( [&joined,&child](){
+                    guard g( joined);
+                    ctx::nursery n;
+                    n.spawn( [&child](){
+                                guard g( child);
+                                ctx::scheduler::current()->suspend();
+                             });
+                    n.join();
+                 });
+        s.run();
+        BOOST_CHECK_EQUAL( 3u, s.live() );
+        BOOST_CHECK( ! suspended);
+        // never resumed, the function is not entered
+        s.spawn( [&unstarted](){
+                    unstarted = true;
+                 });
+    }
+    BOOST_CHECK( suspended);
+    BOOST_CHECK( joined);
+    BOOST_CHECK( child);
+    BOOST_CHECK( ! unstarted);
+}
+
+void test_file_io( ctx::io_driver::backend_t backend) {
+    char name[] = "/tmp/test_scheduler_XXXXXX";
+    int fd = ::mkstemp( name);
+    BOOST_REQUIRE( 0 <= fd);
+    ::unlink( name);
+    ctx::scheduler s;
+    ctx::io_driver io( s, backend);
+    std::string result;
+    s.spawn( [&io,&result,fd](){
+                char const msg[] = "hello world";
+                BOOST_CHECK_EQUAL( ssize_t( sizeof( msg) ), io.write( fd, msg, sizeof( msg), 0) );
+                BOOST_CHECK_EQUAL( 0, io.fsync( fd) );
+                char buf[sizeof( msg)];
+                BOOST_CHECK_EQUAL( ssize_t( sizeof( msg) ), io.read( fd, buf, sizeof( buf), 0) );
+                result = buf;
+             });
+    s.spawn( [&io](){
+                char buf[1];
+                BOOST_CHECK_EQUAL( -1, io.read( -1, buf, sizeof( buf) ) );
+                BOOST_CHECK_EQUAL( EBADF, errno);
+             });
+    s.run();
+    ::close( fd);
+    BOOST_CHECK_EQUAL( std::string("hello world"), result);
+}
+
+void test_accept( ctx::io_driver::backend_t backend) {
+    int lfd = ::socket( AF_INET, SOCK_STREAM, 0);
+    BOOST_REQUIRE( 0 <= lfd);
+    sockaddr_in addr;
+    std::memset( & addr, 0, sizeof( addr) );
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK);
+    socklen_t len = sizeof( addr);
+    BOOST_REQUIRE( 0 == ::bind( lfd, reinterpret_cast< sockaddr * >( & addr), len) );
+    BOOST_REQUIRE( 0 == ::listen( lfd, 1) );
+    BOOST_REQUIRE( 0 == ::getsockname( lfd, reinterpret_cast< sockaddr * >( & addr), & len) );
+    ctx::scheduler s;
+    ctx::io_driver io( s, backend);
+    char received = 0;
+    s.spawn( [&io,&received,lfd](){
+                int fd = io.accept( lfd);
+                BOOST_REQUIRE( 0 <= fd);
+                BOOST_CHECK_EQUAL( 1, io.read( fd, & received, 1) );
+                ::close( fd);
+             });
+    s.spawn( [&io,&addr,len](){
+                int fd = ::socket( AF_INET, SOCK_STREAM, 0);
+                BOOST_REQUIRE( 0 == ::connect( fd, reinterpret_cast< sockaddr * >( & addr), len) );
+                BOOST_CHECK_EQUAL( 1, io.write( fd, "x", 1) );
+                ::close( fd);
+             });
+    s.run();
+    ::close( lfd);
+    BOOST_CHECK_EQUAL( 'x', received);
+}
+
+// more requests in flight than entries in the submission and completion
+// queue of io_uring
+void test_queue_full( ctx::io_driver::backend_t backend) {
+    char name[] = "/tmp/test_scheduler_XXXXXX";
+    int fd = ::mkstemp( name);
+    BOOST_REQUIRE( 0 <= fd);
+    ::unlink( name);
+    ctx::scheduler s;
+    ctx::io_driver io( s, backend, 2);
+    int completed = 0;
+    for ( int i = 0; i < 64; ++i) {
+        s.spawn( [&io,&completed,fd,i](){
+                    char c = static_cast< char >( 'a' + i % 26);
+                    BOOST_CHECK_EQUAL( 1, io.write( fd, & c, 1, i) );
+                    char r = 0;
+                    BOOST_CHECK_EQUAL( 1, io.read( fd, & r, 1, i) );
+                    BOOST_CHECK_EQUAL( c, r);
+                    ++completed;
+                 });
+    }
+    s.run();
+    ::close( fd);
+    BOOST_CHECK_EQUAL( 64, completed);
+}
+
+void test_cancel_io( ctx::io_driver::backend_t backend) {
+    int p[2];
+    BOOST_REQUIRE( 0 == ::pipe( p) );
+    ctx::scheduler s;
+    ctx::io_driver io( s, backend);
+    ctx::task_handle reader;
+    char received = 0;
+    bool unwound = false, resumed = false;
+    s.spawn( [&](){
+                reader = ctx::scheduler::current()->running();
+                guard g( unwound);
+                // not a cancellation point, the request completes
+                BOOST_CHECK_EQUAL( 1, io.read( p[0], & received, 1) );
+                BOOST_CHECK( ! unwound);
+                ctx::scheduler::current()->yield();
+                resumed = true;
+             });
+    s.spawn( [&](){
+                ctx::scheduler::current()->cancel( reader);
+                BOOST_CHECK_EQUAL( 1, ::write( p[1], "x", 1) );
+             });
+    s.run();
+    ::close( p[0]);
+    ::close( p[1]);
+    BOOST_CHECK_EQUAL( 'x', received);
+    BOOST_CHECK( unwound);
+    BOOST_CHECK( ! resumed);
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+}
+
+void test_io_uring() {
+    try {
+        test_file_io( ctx::io_driver::backend_io_uring);
+        test_accept( ctx::io_driver::backend_io_uring);
+        test_cancel_io( ctx::io_driver::backend_io_uring);
+        test_queue_full( ctx::io_driver::backend_io_uring);
+    } catch ( std::system_error const& e) {
+        BOOST_TEST_MESSAGE( "io_uring not available: " << e.what() );
+    }
+}
+
+void test_thread_pool() {
+    test_file_io( ctx::io_driver::backend_thread_pool);
+    test_accept( ctx::io_driver::backend_thread_pool);
+    test_cancel_io( ctx::io_driver::backend_thread_pool);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* [])
+{
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Context: scheduler test suite");
+
+    test->add( BOOST_TEST_CASE( & test_yield) );
+    test->add( BOOST_TEST_CASE( & test_sleep) );
+    test->add( BOOST_TEST_CASE( & test_suspend_until) );
+    test->add( BOOST_TEST_CASE( & test_time_slice) );
+    test->add( BOOST_TEST_CASE( & test_priority) );
+    test->add( BOOST_TEST_CASE( & test_deadline) );
+    test->add( BOOST_TEST_CASE( & test_starvation) );
+    test->add( BOOST_TEST_CASE( & test_switch_to) );
+    test->add( BOOST_TEST_CASE( & test_nursery) );
+    test->add( BOOST_TEST_CASE( & test_cancel) );
+    test->add( BOOST_TEST_CASE( & test_destroy) );
+    test->add( BOOST_TEST_CASE( & test_io_uring) );
+    test->add( BOOST_TEST_CASE( & test_thread_pool) );
+
+    return test;
+}
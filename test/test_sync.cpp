@@ -0,0 +1,367 @@
+//          Copyright Oliver Kowalke 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <boost/context/all.hpp>
+#include <boost/context/detail/config.hpp>
+
+namespace ctx = boost::context;
+
+std::vector< int > trace;
+
+void test_mutex_fifo() {
+    trace.clear();
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    s.spawn( [&mtx](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+                // let the other contexts queue up
+                ctx::scheduler::current()->yield();
+                trace.push_back( 0);
+             });
+    for ( int i = 1; i < 4; ++i) {
+        s.spawn( [&mtx,i](){
+                    std::unique_lock< ctx::mutex > lk( mtx);
+                    trace.push_back( i);
+                 });
+    }
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    BOOST_REQUIRE_EQUAL( 4u, trace.size() );
+    for ( int i = 0; i < 4; ++i) {
+        BOOST_CHECK_EQUAL( i, trace[i]);
+    }
+}
+
+void test_mutex_handoff() {
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    bool barged = false;
+    s.spawn( [&mtx](){
+                mtx.lock();
+                ctx::scheduler::current()->yield();
+                // hands the mutex to the waiting context
+                mtx.unlock();
+             });
+    s.spawn( [&mtx](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+             });
+    s.spawn( [&mtx,&barged](){
+                // runs after unlock() but before the waiter was resumed
+                ctx::scheduler::current()->yield();
+                barged = mtx.try_lock();
+                if ( barged) {
+                    mtx.unlock();
+                }
+             });
+    s.run();
+    BOOST_CHECK( ! barged);
+}
+
+void test_mutex_timeout() {
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    bool acquired = true;
+    s.spawn( [&mtx](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+                ctx::scheduler::current()->sleep_for( std::chrono::milliseconds( 50) );
+             });
+    s.spawn( [&mtx,&acquired](){
+                acquired = mtx.try_lock_for( std::chrono::milliseconds( 5) );
+             });
+    s.run();
+    BOOST_CHECK( ! acquired);
+    BOOST_CHECK( mtx.try_lock() );
+    mtx.unlock();
+}
+
+void test_condition_variable() {
+    trace.clear();
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    ctx::condition_variable cond;
+    int value = 0;
+    for ( int i = 0; i < 3; ++i) {
+        s.spawn( [&mtx,&cond,&value,i](){
+                    std::unique_lock< ctx::mutex > lk( mtx);
+                    cond.wait( lk, [&value](){ return 0 != value; });
+                    trace.push_back( i);
+                 });
+    }
+    s.spawn( [&mtx,&cond,&value](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+                value = 1;
+                cond.notify_all();
+             });
+    s.run();
+    BOOST_CHECK_EQUAL( 0u, s.live() );
+    BOOST_REQUIRE_EQUAL( 3u, trace.size() );
+    for ( int i = 0; i < 3; ++i) {
+        BOOST_CHECK_EQUAL( i, trace[i]);
+    }
+}
+
+void test_condition_variable_timeout() {
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    ctx::condition_variable cond;
+    ctx::cv_status status = ctx::cv_status::no_timeout;
+    s.spawn( [&mtx,&cond,&status](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+                status = cond.wait_for( lk, std::chrono::milliseconds( 5) );
+                BOOST_CHECK( lk.owns_lock() );
+             });
+    s.run();
+    BOOST_CHECK( ctx::cv_status::timeout == status);
+}
+
+void test_semaphore() {
+    trace.clear();
+    ctx::scheduler s;
+    ctx::semaphore sem( 1);
+    for ( int i = 0; i < 3; ++i) {
+        s.spawn( [&sem,i](){
+                    sem.acquire();
+                    trace.push_back( i);
+                    ctx::scheduler::current()->yield();
+                    trace.push_back( i);
+                    sem.release();
+                 });
+    }
+    s.run();
+    BOOST_REQUIRE_EQUAL( 6u, trace.size() );
+    // the permit serializes the contexts
+    for ( int i = 0; i < 3; ++i) {
+        BOOST_CHECK_EQUAL( i, trace[2 * i]);
+        BOOST_CHECK_EQUAL( i, trace[2 * i + 1]);
+    }
+    BOOST_CHECK( sem.try_acquire() );
+    BOOST_CHECK( ! sem.try_acquire_for( std::chrono::milliseconds( 1) ) );
+}
+
+void test_cross_thread() {
+    // contexts of two schedulers and a plain thread contend for one mutex
+    const int n = 1000;
+    ctx::mutex mtx;
+    int counter = 0;
+    auto worker = [&mtx,&counter,n](){
+        ctx::scheduler s;
+        for ( int i = 0; i < 4; ++i) {
+            s.spawn( [&mtx,&counter,n](){
+                        for ( int j = 0; j < n; ++j) {
+                            std::unique_lock< ctx::mutex > lk( mtx);
+                            ++counter;
+                            if ( 0 == j % 8) {
+                                // keep the mutex while suspended
+                                ctx::scheduler::current()->yield();
+                            }
+                        }
+                     });
+        }
+        s.run();
+    };
+    std::thread t1( worker);
+    std::thread t2( worker);
+    for ( int j = 0; j < n; ++j) {
+        std::unique_lock< ctx::mutex > lk( mtx);
+        ++counter;
+    }
+    t1.join();
+    t2.join();
+    BOOST_CHECK_EQUAL( 9 * n, counter);
+}
+
+void test_cross_thread_notify() {
+    ctx::scheduler s;
+    ctx::mutex mtx;
+    ctx::condition_variable cond;
+    bool flag = false, done = false;
+    s.spawn( [&mtx,&cond,&flag,&done](){
+                std::unique_lock< ctx::mutex > lk( mtx);
+                cond.wait( lk, [&flag](){ return flag; });
+                done = true;
+             });
+    std::thread t( [&mtx,&cond,&flag](){
+                std::this_thread::sleep_for( std::chrono::milliseconds( 10) );
+                std::unique_lock< ctx::mutex > lk( mtx);
+                flag = true;
+                cond.notify_one();
+             });
+    // the dispatcher blocks until the context is woken by the thread
+    s.run();
+    t.join();
+    BOOST_CHECK( done);
+}
+
+void test_channel() {
+    ctx::scheduler s;
+    ctx::channel< int > ch( 2);
+    std::vector< int > received;
+    s.spawn( [&ch](){
+                for ( int i = 0; i < 10; ++i) {
+                    BOOST_CHECK( ctx::channel_op_status::success == ch.push( i) );
+                }
+                ch.close();
+             });
+    s.spawn( [&ch,&received](){
+                int v = 0;
+                while ( ctx::channel_op_status::success == ch.pop( v) ) {
+                    received.push_back( v);
+                }
+             });
+    s.run();
+    BOOST_REQUIRE_EQUAL( 10u, received.size() );
+    for ( int i = 0; i < 10; ++i) {
+        BOOST_CHECK_EQUAL( i, received[i]);
+    }
+}
+
+void test_channel_try() {
+    ctx::local_channel< std::string > ch( 1);
+    std::string v;
+    BOOST_CHECK( ctx::channel_op_status::empty == ch.try_pop( v) );
+    BOOST_CHECK( ctx::channel_op_status::success == ch.try_push( std::string("abc") ) );
+    BOOST_CHECK( ctx::channel_op_status::full == ch.try_push( std::string("def") ) );
+    BOOST_CHECK( ctx::channel_op_status::success == ch.try_pop( v) );
+    BOOST_CHECK_EQUAL( std::string("abc"), v);
+    ch.close();
+    BOOST_CHECK( ch.is_closed() );
+    BOOST_CHECK( ctx::channel_op_status::closed == ch.try_push( std::string("ghi") ) );
+    BOOST_CHECK( ctx::channel_op_status::closed == ch.try_pop( v) );
+}
+
+void test_channel_handoff() {
+    trace.clear();
+    ctx::scheduler s;
+    ctx::local_channel< int > ch( 1);
+    s.spawn( [&ch](){
+                int v = 0;
+                ch.pop( v);
+                trace.push_back( v);
+                ch.pop( v);
+                trace.push_back( v);
+             });
+    s.spawn( [&ch](){
+                // the waiting consumer receives 1 directly, 2 is buffered,
+                // 3 waits for a free slot
+                ch.push( 1);
+                ch.push( 2);
+                ch.push( 3);
+                trace.push_back( 0);
+             });
+    s.run();
+    BOOST_REQUIRE_EQUAL( 3u, trace.size() );
+    BOOST_CHECK_EQUAL( 1, trace[0]);
+    BOOST_CHECK_EQUAL( 2, trace[1]);
+    BOOST_CHECK_EQUAL( 0, trace[2]);
+    int v = 0;
+    BOOST_CHECK( ctx::channel_op_status::success == ch.try_pop( v) );
+    BOOST_CHECK_EQUAL( 3, v);
+    s.spawn( [&ch](){
+                int v = 0;
+                BOOST_CHECK( ctx::channel_op_status::timeout ==
+                             ch.pop_wait_for( v, std::chrono::milliseconds( 1) ) );
+             });
+    s.run();
+}
+
+void test_select() {
+    ctx::scheduler s;
+    ctx::channel< int > ch1( 1);
+    ctx::channel< std::string > ch2( 1);
+    std::vector< std::size_t > selected;
+    s.spawn( [&ch1,&ch2,&selected](){
+                int i = 0;
+                std::string str;
+                for ( int n = 0; n < 2; ++n) {
+                    ctx::select_result r = ctx::select(
+                            ctx::select_pop( ch1, i),
+                            ctx::select_pop( ch2, str) );
+                    BOOST_CHECK( ctx::channel_op_status::success == r.status);
+                    selected.push_back( r.index);
+                }
+                BOOST_CHECK_EQUAL( 7, i);
+                BOOST_CHECK_EQUAL( std::string("abc"), str);
+                ctx::select_result r = ctx::select_for(
+                        std::chrono::milliseconds( 1),
+                        ctx::select_pop( ch1, i),
+                        ctx::select_pop( ch2, str) );
+                BOOST_CHECK_EQUAL( 2u, r.index);
+                BOOST_CHECK( ctx::channel_op_status::timeout == r.status);
+                ch1.close();
+                r = ctx::select( ctx::select_pop( ch2, str), ctx::select_pop( ch1, i) );
+                BOOST_CHECK_EQUAL( 1u, r.index);
+                BOOST_CHECK( ctx::channel_op_status::closed == r.status);
+             });
+    s.spawn( [&ch1,&ch2](){
+                ch2.push( std::string("abc") );
+                ctx::scheduler::current()->yield();
+                ch1.push( 7);
+             });
+    s.run();
+    BOOST_REQUIRE_EQUAL( 2u, selected.size() );
+    BOOST_CHECK_EQUAL( 1u, selected[0]);
+    BOOST_CHECK_EQUAL( 0u, selected[1]);
+}
+
+void test_channel_cross_thread() {
+    const int n = 10000;
+    ctx::channel< int > ch( 16);
+    long sum = 0;
+    std::thread t( [&ch,&sum](){
+                ctx::scheduler s;
+                for ( int i = 0; i < 2; ++i) {
+                    s.spawn( [&ch,&sum](){
+                                int v = 0;
+                                while ( ctx::channel_op_status::success == ch.pop( v) ) {
+                                    sum += v;
+                                }
+                             });
+                }
+                s.run();
+             });
+    ctx::scheduler s;
+    for ( int i = 0; i < 2; ++i) {
+        s.spawn( [&ch,n](){
+                    for ( int j = 1; j <= n; ++j) {
+                        ch.push( j);
+                    }
+                 });
+    }
+    s.run();
+    ch.close();
+    t.join();
+    BOOST_CHECK_EQUAL( static_cast< long >( n) * ( n + 1), sum);
+}
+
+boost::unit_test::test_suite * init_unit_test_suite( int, char* [])
+{
+    boost::unit_test::test_suite * test =
+        BOOST_TEST_SUITE("Boost.Context: synchronization test suite");
+
+    test->add( BOOST_TEST_CASE( & test_mutex_fifo) );
+    test->add( BOOST_TEST_CASE( & test_mutex_handoff) );
+    test->add( BOOST_TEST_CASE( & test_mutex_timeout) );
+    test->add( BOOST_TEST_CASE( & test_condition_variable) );
+    test->add( BOOST_TEST_CASE( & test_condition_variable_timeout) );
+    test->add( BOOST_TEST_CASE( & test_semaphore) );
+    test->add( BOOST_TEST_CASE( & test_cross_thread) );
+    test->add( BOOST_TEST_CASE( & test_cross_thread_notify) );
+    test->add( BOOST_TEST_CASE( & test_channel) );
+    test->add( BOOST_TEST_CASE( & test_channel_try) );
+    test->add( BOOST_TEST_CASE( & test_channel_handoff) );
+    test->add( BOOST_TEST_CASE( & test_select) );
+    test->add( BOOST_TEST_CASE( & test_channel_cross_thread) );
+
+    return test;
+}